@@ -21,6 +21,7 @@
 #include "ai_config.hpp"
 #include "ai_info.hpp"
 #include "ai.hpp"
+#include "../tick_timing.h"
 
 #include "../safeguards.h"
 
@@ -67,6 +68,8 @@
 
 /* static */ void AI::GameLoop()
 {
+	TickTimer timer(TTP_AI);
+
 	/* If we are in networking, only servers run this function, and that only if it is allowed */
 	if (_networking && (!_network_server || !_settings_game.ai.ai_in_multiplayer)) return;
 
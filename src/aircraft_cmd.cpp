@@ -38,6 +38,7 @@
 #include "infrastructure_func.h"
 #include "zoom_func.h"
 #include "disaster_vehicle.h"
+#include "tick_timing.h"
 
 #include "table/strings.h"
 
@@ -2108,6 +2109,8 @@ bool Aircraft::Tick()
 {
 	if (!this->IsNormalAircraft()) return true;
 
+	TickTimer timer(TTP_AIRCRAFT);
+
 	this->tick_counter++;
 
 	if (!(this->vehstatus & VS_STOPPED)) this->running_ticks++;
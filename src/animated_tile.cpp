@@ -13,6 +13,7 @@
 #include "core/alloc_func.hpp"
 #include "tile_cmd.h"
 #include "viewport_func.h"
+#include "tick_timing.h"
 
 #include "safeguards.h"
 
@@ -71,6 +72,8 @@ void AddAnimatedTile(TileIndex tile)
  */
 void AnimateAnimatedTiles()
 {
+	TickTimer timer(TTP_ANIMATED_TILES);
+
 	const TileIndex *ti = _animated_tile_list;
 	while (ti < _animated_tile_list + _animated_tile_count) {
 		const TileIndex curr = *ti;
@@ -26,7 +26,7 @@ typedef uint32 CargoPacketID;
 struct CargoPacket;
 
 /** Type of the pool for cargo packets for a little over 16 million packets. */
-typedef Pool<CargoPacket, CargoPacketID, 1024, 0xFFF000, PT_NORMAL, true, false> CargoPacketPool;
+typedef Pool<CargoPacket, CargoPacketID, 1024, 0xFFF000, PT_NORMAL, false, false, true> CargoPacketPool;
 /** The actual pool with cargo packets. */
 extern CargoPacketPool _cargopacket_pool;
 
@@ -36,6 +36,7 @@
 #include "game/game.hpp"
 #include "goal_base.h"
 #include "story_base.h"
+#include "tick_timing.h"
 
 #include "table/strings.h"
 
@@ -700,6 +701,8 @@ static void HandleBankruptcyTakeover(Company *c)
 /** Called every tick for updating some company info. */
 void OnTick_Companies()
 {
+	TickTimer timer(TTP_COMPANIES);
+
 	if (_game_mode == GM_EDITOR) return;
 
 	Company *c = Company::GetIfValid(_cur_company_tick_index);
@@ -825,13 +828,11 @@ CommandCost CmdCompanyCtrl(TileIndex tile, DoCommandFlag flags, uint32 p1, uint3
 			/* Has the network client a correct ClientIndex? */
 			if (!(flags & DC_EXEC)) return CommandCost();
 			NetworkClientInfo *ci = NetworkClientInfo::GetByClientID(client_id);
-#ifndef DEBUG_DUMP_COMMANDS
 			/* When replaying the client ID is not a valid client; there
 			 * are actually no clients at all. However, the company has to
 			 * be created, otherwise we cannot rerun the game properly.
 			 * So only allow a NULL client info in that case. */
-			if (ci == NULL) return CommandCost();
-#endif /* NOT DEBUG_DUMP_COMMANDS */
+			if (ci == NULL && !_network_replaying) return CommandCost();
 
 			/* Delete multiplayer progress bar */
 			DeleteWindowById(WC_NETWORK_STATUS_WINDOW, WN_NETWORK_STATUS_WINDOW_JOIN);
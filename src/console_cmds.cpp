@@ -42,6 +42,8 @@
 #include "aircraft.h"
 #include "airport.h"
 #include "station_base.h"
+#include "pathfinder/yapf/yapf_cache.h"
+#include "tick_timing.h"
 
 #include "safeguards.h"
 
@@ -1959,6 +1961,75 @@ DEF_CONSOLE_CMD(ConDumpCommandLog)
 	return true;
 }
 
+DEF_CONSOLE_CMD(ConYapfCacheStats)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show hit/miss statistics of the YAPF rail segment cost cache. Usage: 'yapf_cache_stats [reset]'");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	if (argc == 2) {
+		if (strcmp(argv[1], "reset") != 0) return false;
+		ResetYapfSegmentCacheStats();
+		IConsolePrint(CC_DEFAULT, "YAPF segment cost cache statistics reset");
+		return true;
+	}
+
+	char buffer[1024];
+	DumpYapfSegmentCacheStats(buffer, lastof(buffer));
+	PrintLineByLine(buffer);
+	return true;
+}
+
+DEF_CONSOLE_CMD(ConTickTimings)
+{
+	if (argc == 0) {
+		IConsoleHelp("Show the time spent in the parts of the game tick over the last ticks. Usage: 'tick_timings [reset | <part>]'");
+		IConsoleHelp("Giving the name of a part shows the histogram of its time per tick.");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	if (argc == 2 && strcmp(argv[1], "reset") == 0) {
+		ResetTickTimings();
+		IConsolePrint(CC_DEFAULT, "Tick timings reset");
+		return true;
+	}
+
+	TickTimingStats stats;
+	if (argc == 2) {
+		TickTimingPhase phase = GetTickTimingPhaseByName(argv[1]);
+		if (phase == TTP_END) {
+			IConsolePrintF(CC_ERROR, "Unknown part of the game tick '%s'", argv[1]);
+			return true;
+		}
+
+		GetTickTimingStats(phase, &stats);
+		IConsolePrintF(CC_DEFAULT, "Time per tick of '%s' over the last %u ticks:", argv[1], stats.samples);
+		for (uint i = 0; i < TICK_TIMING_BUCKETS; i++) {
+			if (i < TICK_TIMING_BUCKETS - 1) {
+				IConsolePrintF(CC_DEFAULT, "  < %6u us: %u", 1 << i, stats.buckets[i]);
+			} else {
+				IConsolePrintF(CC_DEFAULT, " >= %6u us: %u", 1 << (i - 1), stats.buckets[i]);
+			}
+		}
+		return true;
+	}
+
+	GetTickTimingStats(TTP_GAME_LOOP, &stats);
+	IConsolePrintF(CC_DEFAULT, "Time per tick over the last %u ticks, in milliseconds:", stats.samples);
+	IConsolePrintF(CC_DEFAULT, "  %-16s %8s %8s %8s %8s", "part", "average", "median", "99%", "max");
+	for (uint i = 0; i < TTP_END; i++) {
+		GetTickTimingStats((TickTimingPhase)i, &stats);
+		IConsolePrintF(CC_DEFAULT, "  %-16s %8.3f %8.3f %8.3f %8.3f", GetTickTimingName((TickTimingPhase)i),
+				stats.average / 1e6, stats.median / 1e6, stats.p99 / 1e6, stats.max / 1e6);
+	}
+	return true;
+}
+
 DEF_CONSOLE_CMD(ConCheckCaches)
 {
 	if (argc == 0) {
@@ -2125,6 +2196,8 @@ void IConsoleStdLibRegister()
 #endif
 	IConsoleCmdRegister("dump_command_log", ConDumpCommandLog, nullptr, true);
 	IConsoleCmdRegister("check_caches", ConCheckCaches, nullptr, true);
+	IConsoleCmdRegister("yapf_cache_stats", ConYapfCacheStats, nullptr, true);
+	IConsoleCmdRegister("tick_timings", ConTickTimings);
 
 	/* NewGRF development stuff */
 	IConsoleCmdRegister("reload_newgrfs",  ConNewGRFReload, ConHookNewGRFDeveloperTool);
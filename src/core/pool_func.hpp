@@ -21,8 +21,8 @@
  * @param type The return type of the method.
  */
 #define DEFINE_POOL_METHOD(type) \
-	template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, PoolType Tpool_type, bool Tcache, bool Tzero> \
-	type Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tcache, Tzero>
+	template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, PoolType Tpool_type, bool Tcache, bool Tzero, bool Tslab> \
+	type Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tcache, Tzero, Tslab>
 
 /**
  * Create a clean pool.
@@ -40,6 +40,8 @@ DEFINE_POOL_METHOD(inline)::Pool(const char *name) :
 #endif /* OTTD_ASSERT */
 		cleaning(false),
 		data(NULL),
+		slabs(NULL),
+		used(NULL),
 		alloc_cache(NULL)
 { }
 
@@ -59,6 +61,18 @@ DEFINE_POOL_METHOD(inline void)::ResizeFor(size_t index)
 	this->data = ReallocT(this->data, new_size);
 	MemSetT(this->data + this->size, 0, new_size - this->size);
 
+	if (Tslab) {
+		size_t old_slabs = CeilDivT<size_t>(this->size, Tgrowth_step);
+		size_t new_slabs = CeilDivT<size_t>(new_size, Tgrowth_step);
+		this->slabs = ReallocT(this->slabs, new_slabs);
+		for (size_t i = old_slabs; i < new_slabs; i++) this->slabs[i] = MallocT<byte>(Tgrowth_step * sizeof(Titem));
+
+		size_t old_words = CeilDivT<size_t>(this->size, 64);
+		size_t new_words = CeilDivT<size_t>(new_size, 64);
+		this->used = ReallocT(this->used, new_words);
+		MemSetT(this->used + old_words, 0, new_words - old_words);
+	}
+
 	this->size = new_size;
 }
 
@@ -70,6 +84,21 @@ DEFINE_POOL_METHOD(inline size_t)::FindFirstFree()
 {
 	size_t index = this->first_free;
 
+	if (Tslab) {
+		/* Skip the completely used parts of the bitmap 64 indices at a time. */
+		while (index < this->first_unused) {
+			uint64 bits = ~this->used[index / 64] & (~(uint64)0 << (index % 64));
+			if (bits != 0) {
+				uint32 low = (uint32)bits;
+				index = (index & ~(size_t)63) + (low != 0 ? FindFirstBit(low) : 32 + FindFirstBit((uint32)(bits >> 32)));
+				break;
+			}
+			index = (index & ~(size_t)63) + 64;
+		}
+		if (index < this->first_unused) return index;
+		index = this->first_unused;
+	}
+
 	for (; index < this->first_unused; index++) {
 		if (this->data[index] == NULL) return index;
 	}
@@ -106,7 +135,12 @@ DEFINE_POOL_METHOD(inline void *)::AllocateItem(size_t size, size_t index)
 	this->items++;
 
 	Titem *item;
-	if (Tcache && this->alloc_cache != NULL) {
+	if (Tslab) {
+		assert(sizeof(Titem) == size);
+		item = (Titem *)(this->slabs[index / Tgrowth_step] + (index % Tgrowth_step) * sizeof(Titem));
+		SetBit(this->used[index / 64], index % 64);
+		if (Tzero) memset((void *)item, 0, sizeof(Titem));
+	} else if (Tcache && this->alloc_cache != NULL) {
 		assert(sizeof(Titem) == size);
 		item = (Titem *)this->alloc_cache;
 		this->alloc_cache = this->alloc_cache->next;
@@ -179,7 +213,9 @@ DEFINE_POOL_METHOD(void)::FreeItem(size_t index)
 {
 	assert(index < this->size);
 	assert(this->data[index] != NULL);
-	if (Tcache) {
+	if (Tslab) {
+		ClrBit(this->used[index / 64], index % 64);
+	} else if (Tcache) {
 		AllocCache *ac = (AllocCache *)this->data[index];
 		ac->next = this->alloc_cache;
 		this->alloc_cache = ac;
@@ -202,6 +238,13 @@ DEFINE_POOL_METHOD(void)::CleanPool()
 	}
 	assert(this->items == 0);
 	free(this->data);
+	if (Tslab) {
+		for (size_t i = 0; i < CeilDivT<size_t>(this->size, Tgrowth_step); i++) free(this->slabs[i]);
+		free(this->slabs);
+		free(this->used);
+		this->slabs = NULL;
+		this->used = NULL;
+	}
 	this->first_unused = this->first_free = this->size = 0;
 	this->data = NULL;
 	this->cleaning = false;
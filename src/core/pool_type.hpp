@@ -14,6 +14,7 @@
 
 #include "smallvec_type.hpp"
 #include "enum_type.hpp"
+#include "bitmath_func.hpp"
 
 /** Various types of a pool. */
 enum PoolType {
@@ -77,9 +78,11 @@ private:
  * @tparam Tpool_type   Type of this pool
  * @tparam Tcache       Whether to perform 'alloc' caching, i.e. don't actually free/malloc just reuse the memory
  * @tparam Tzero        Whether to zero the memory
- * @warning when Tcache is enabled *all* instances of this pool's item must be of the same size.
+ * @tparam Tslab        Whether to allocate the items in contiguous slabs of Tgrowth_step items instead of one by one,
+ *                      and keep a bitmap of the used indices for finding free items and iterating over the used items
+ * @warning when Tcache or Tslab is enabled *all* instances of this pool's item must be of the same size.
  */
-template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, PoolType Tpool_type = PT_NORMAL, bool Tcache = false, bool Tzero = true>
+template <class Titem, typename Tindex, size_t Tgrowth_step, size_t Tmax_size, PoolType Tpool_type = PT_NORMAL, bool Tcache = false, bool Tzero = true, bool Tslab = false>
 struct Pool : PoolBase {
 	/* Ensure Tmax_size is within the bounds of Tindex. */
 	assert_compile((uint64)(Tmax_size - 1) >> 8 * sizeof(Tindex) == 0);
@@ -99,6 +102,9 @@ struct Pool : PoolBase {
 
 	Titem **data;        ///< Pointer to array of pointers to Titem
 
+	byte **slabs;        ///< Slabs holding the items, each of Tgrowth_step items; only used when Tslab
+	uint64 *used;        ///< Bitmap of the used indices; only used when Tslab
+
 	Pool(const char *name);
 	virtual void CleanPool();
 
@@ -124,6 +130,27 @@ struct Pool : PoolBase {
 		return index < this->first_unused && this->Get(index) != NULL;
 	}
 
+	/**
+	 * Find the first used index, starting at a given index.
+	 * Without Tslab this does not look at the items at all, the caller has to skip the unused ones.
+	 * @param index Index to start searching at.
+	 * @return The first used index not lower than \a index, or an index not lower than first_unused if there is none.
+	 */
+	inline size_t FindNextUsed(size_t index)
+	{
+		if (!Tslab || index >= this->first_unused) return index;
+
+		size_t word = index / 64;
+		uint64 bits = this->used[word] & (~(uint64)0 << (index % 64));
+		size_t last_word = (this->first_unused - 1) / 64;
+		while (bits == 0) {
+			if (++word > last_word) return this->first_unused;
+			bits = this->used[word];
+		}
+		uint32 low = (uint32)bits;
+		return word * 64 + (low != 0 ? FindFirstBit(low) : 32 + FindFirstBit((uint32)(bits >> 32)));
+	}
+
 	/**
 	 * Tests whether we can allocate 'n' items
 	 * @param n number of items we want to allocate
@@ -142,7 +169,7 @@ struct Pool : PoolBase {
 	 * Base class for all PoolItems
 	 * @tparam Tpool The pool this item is going to be part of
 	 */
-	template <struct Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tcache, Tzero> *Tpool>
+	template <struct Pool<Titem, Tindex, Tgrowth_step, Tmax_size, Tpool_type, Tcache, Tzero, Tslab> *Tpool>
 	struct PoolItem {
 		Tindex index; ///< Index of this pool item
 
@@ -269,6 +296,17 @@ struct Pool : PoolBase {
 			return Tpool->first_unused;
 		}
 
+		/**
+		 * Returns the first index which may hold a valid item, starting at a given index.
+		 * Used when iterating over all pool items, to quickly skip unused indices in slab pools.
+		 * @param index index to start at
+		 * @return the index of the next item, or at least GetPoolSize() when there is none
+		 */
+		static inline size_t GetNextUsedIndex(size_t index)
+		{
+			return Tpool->FindNextUsed(index);
+		}
+
 		/**
 		 * Returns number of valid items in the pool
 		 * @return number of valid items in the pool
@@ -321,7 +359,7 @@ private:
 };
 
 #define FOR_ALL_ITEMS_FROM(type, iter, var, start) \
-	for (size_t iter = start; var = NULL, iter < type::GetPoolSize(); iter++) \
+	for (size_t iter = type::GetNextUsedIndex(start); var = NULL, iter < type::GetPoolSize(); iter = type::GetNextUsedIndex(iter + 1)) \
 		if ((var = type::Get(iter)) != NULL)
 
 #define FOR_ALL_ITEMS(type, iter, var) FOR_ALL_ITEMS_FROM(type, iter, var, 0)
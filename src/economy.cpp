@@ -53,6 +53,7 @@
 #include "linkgraph/refresh.h"
 #include "tracerestrict.h"
 #include "tbtr_template_vehicle.h"
+#include "pathfinder/yapf/yapf_cache.h"
 
 #include "table/strings.h"
 #include "table/pricebase.h"
@@ -528,6 +529,9 @@ void ChangeOwnershipOfCompanyItems(Owner old_owner, Owner new_owner)
 			ChangeTileOwner(tile, old_owner, new_owner);
 		} while (++tile != MapSize());
 
+		/* Which tracks trains may use depends on their owner. */
+		YapfNotifyTrackLayoutChange(INVALID_TILE, INVALID_TRACK);
+
 		if (new_owner != INVALID_OWNER) {
 			/* Update all signals because there can be new segment that was owned by two companies
 			 * and signals were not propagated
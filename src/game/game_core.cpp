@@ -20,6 +20,7 @@
 #include "game_config.hpp"
 #include "game_instance.hpp"
 #include "game_info.hpp"
+#include "../tick_timing.h"
 
 #include "../safeguards.h"
 
@@ -31,6 +32,8 @@
 
 /* static */ void Game::GameLoop()
 {
+	TickTimer timer(TTP_GAME_SCRIPT);
+
 	if (_networking && !_network_server) return;
 	if (Game::instance == NULL) return;
 
@@ -34,6 +34,7 @@
 #include "game/game.hpp"
 #include "game/game_instance.hpp"
 #include "string_func.h"
+#include "thread/thread_pool.h"
 
 #include "safeguards.h"
 
@@ -241,14 +242,13 @@ void GenerateWorldSetAbortCallback(GWAbortProc *proc)
  */
 void WaitTillGeneratedWorld()
 {
-	if (_gw.thread == NULL) return;
+	if (!_gw.task) return;
 
 	_modal_progress_work_mutex->EndCritical();
 	_modal_progress_paint_mutex->EndCritical();
 	_gw.quit_thread = true;
-	_gw.thread->Join();
-	delete _gw.thread;
-	_gw.thread   = NULL;
+	_gw.task->Join();
+	_gw.task.reset();
 	_gw.threaded = false;
 	_modal_progress_work_mutex->BeginCritical();
 	_modal_progress_paint_mutex->BeginCritical();
@@ -283,7 +283,7 @@ void HandleGeneratingWorldAbortion()
 
 	CleanupGeneration();
 
-	if (_gw.thread != NULL) _gw.thread->Exit();
+	if (_gw.task) ThreadPool::ExitTask();
 
 	SwitchToMode(_switch_mode);
 }
@@ -325,13 +325,12 @@ void GenerateWorld(GenWorldMode mode, uint size_x, uint size_y, bool reset_setti
 	SetupColoursAndInitialWindow();
 	SetObjectToPlace(SPR_CURSOR_ZZZ, PAL_NONE, HT_NONE, WC_MAIN_WINDOW, 0);
 
-	if (_gw.thread != NULL) {
-		_gw.thread->Join();
-		delete _gw.thread;
-		_gw.thread = NULL;
+	if (_gw.task) {
+		_gw.task->Join();
+		_gw.task.reset();
 	}
 
-	if (!VideoDriver::GetInstance()->HasGUI() || !ThreadObject::New(&_GenerateWorld, NULL, &_gw.thread, "ottd:genworld")) {
+	if (!VideoDriver::GetInstance()->HasGUI() || !ThreadPool::Submit(&_GenerateWorld, NULL, &_gw.task, TPTF_BLOCKING, "ottd:genworld")) {
 		DEBUG(misc, 1, "Cannot create genworld thread, reverting to single-threaded mode");
 		_gw.threaded = false;
 		_modal_progress_work_mutex->EndCritical();
@@ -20,7 +20,9 @@
 #include "network/network.h"
 #include "network/network_func.h"
 #include "window_func.h"
+#include "viewport_func.h"
 #include "newgrf_debug.h"
+#include "tick_timing.h"
 
 #include "table/palettes.h"
 #include "table/string_colours.h"
@@ -307,21 +309,31 @@ void DrawBox(int x, int y, int dx1, int dy1, int dx2, int dy2, int dx3, int dy3)
 }
 
 /**
- * Set the colour remap to be for the given colour.
- * @param colour the new colour of the remap.
+ * Fill a colour remap for the given text colour.
+ * @param colour the colour of the remap, not #TC_INVALID.
+ * @param remap the remap to fill; only the entries 1 and 2 are written.
  */
-static void SetColourRemap(TextColour colour)
+static void FillColourRemap(TextColour colour, byte *remap)
 {
-	if (colour == TC_INVALID) return;
-
 	/* Black strings have no shading ever; the shading is black, so it
 	 * would be invisible at best, but it actually makes it illegible. */
 	bool no_shade   = (colour & TC_NO_SHADE) != 0 || colour == TC_BLACK;
 	bool raw_colour = (colour & TC_IS_PALETTE_COLOUR) != 0;
 	colour &= ~(TC_NO_SHADE | TC_IS_PALETTE_COLOUR);
 
-	_string_colourremap[1] = raw_colour ? (byte)colour : _string_colourmap[colour];
-	_string_colourremap[2] = no_shade ? 0 : 1;
+	remap[1] = raw_colour ? (byte)colour : _string_colourmap[colour];
+	remap[2] = no_shade ? 0 : 1;
+}
+
+/**
+ * Set the colour remap to be for the given colour.
+ * @param colour the new colour of the remap.
+ */
+static void SetColourRemap(TextColour colour)
+{
+	if (colour == TC_INVALID) return;
+
+	FillColourRemap(colour, _string_colourremap);
 	_colour_remap_ptr = _string_colourremap;
 }
 
@@ -850,6 +862,8 @@ void DrawSprite(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub,
 
 /**
  * The code for setting up the blitter mode and sprite information before finally drawing the sprite.
+ * @param dpi    The drawing area to draw into.
+ * @param remap  The colour remap to use for the remapping blitter modes.
  * @param sprite The sprite to draw.
  * @param x      The X location to draw.
  * @param y      The Y location to draw.
@@ -860,9 +874,8 @@ void DrawSprite(SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub,
  * @tparam SCALED_XY Whether the X and Y are scaled or unscaled.
  */
 template <int ZOOM_BASE, bool SCALED_XY>
-static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mode, const SubSprite * const sub, SpriteID sprite_id, ZoomLevel zoom)
+static void GfxBlitter(const DrawPixelInfo *dpi, const byte *remap, const Sprite * const sprite, int x, int y, BlitterMode mode, const SubSprite * const sub, SpriteID sprite_id, ZoomLevel zoom)
 {
-	const DrawPixelInfo *dpi = _cur_dpi;
 	Blitter::BlitterParams bp;
 
 	if (SCALED_XY) {
@@ -909,7 +922,7 @@ static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mo
 
 	bp.dst = dpi->dst_ptr;
 	bp.pitch = dpi->pitch;
-	bp.remap = _colour_remap_ptr;
+	bp.remap = remap;
 
 	assert(sprite->width > 0);
 	assert(sprite->height > 0);
@@ -979,12 +992,52 @@ static void GfxBlitter(const Sprite * const sprite, int x, int y, BlitterMode mo
 
 static void GfxMainBlitterViewport(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub, SpriteID sprite_id)
 {
-	GfxBlitter<ZOOM_LVL_BASE, false>(sprite, x, y, mode, sub, sprite_id, _cur_dpi->zoom);
+	GfxBlitter<ZOOM_LVL_BASE, false>(_cur_dpi, _colour_remap_ptr, sprite, x, y, mode, sub, sprite_id, _cur_dpi->zoom);
 }
 
 static void GfxMainBlitter(const Sprite *sprite, int x, int y, BlitterMode mode, const SubSprite *sub, SpriteID sprite_id, ZoomLevel zoom)
 {
-	GfxBlitter<1, true>(sprite, x, y, mode, sub, sprite_id, zoom);
+	GfxBlitter<1, true>(_cur_dpi, _colour_remap_ptr, sprite, x, y, mode, sub, sprite_id, zoom);
+}
+
+/**
+ * Draw a sprite in a viewport into the given drawing area.
+ * Unlike #DrawSpriteViewport this does not use nor change the global drawing state,
+ * so several threads can draw at the same time while the sprite cache is read-only.
+ * @param dpi  Drawing area to draw into.
+ * @param img  Image number to draw
+ * @param pal  Palette to use.
+ * @param x    Left coordinate of image in viewport, scaled by zoom
+ * @param y    Top coordinate of image in viewport, scaled by zoom
+ * @param sub  If available, draw only specified part of the sprite
+ * @see SetSpriteCacheReadOnly
+ */
+void DrawSpriteViewportToArea(const DrawPixelInfo *dpi, SpriteID img, PaletteID pal, int x, int y, const SubSprite *sub)
+{
+	SpriteID real_sprite = GB(img, 0, SPRITE_WIDTH);
+	byte text_remap[3] = { 0, 0, 0 };
+	const byte *remap = NULL;
+	BlitterMode mode = BM_NORMAL;
+
+	if (HasBit(img, PALETTE_MODIFIER_TRANSPARENT)) {
+		remap = GetNonSprite(GB(pal, 0, PALETTE_WIDTH), ST_RECOLOUR) + 1;
+		mode = BM_TRANSPARENT;
+	} else if (pal != PAL_NONE) {
+		if (HasBit(pal, PALETTE_TEXT_RECOLOUR)) {
+			TextColour colour = (TextColour)GB(pal, 0, PALETTE_WIDTH);
+			if (colour == TC_INVALID) {
+				remap = _colour_remap_ptr;
+			} else {
+				FillColourRemap(colour, text_remap);
+				remap = text_remap;
+			}
+		} else {
+			remap = GetNonSprite(GB(pal, 0, PALETTE_WIDTH), ST_RECOLOUR) + 1;
+		}
+		mode = GetBlitterMode(pal);
+	}
+
+	GfxBlitter<ZOOM_LVL_BASE, false>(dpi, remap, GetSprite(real_sprite, ST_NORMAL), x, y, mode, sub, real_sprite, dpi->zoom);
 }
 
 void DoPaletteAnimations();
@@ -1309,6 +1362,8 @@ void RedrawScreenRect(int left, int top, int right, int bottom)
  */
 void DrawDirtyBlocks()
 {
+	TickTimer timer(TTP_DRAWING);
+
 	byte *b = _dirty_blocks;
 	const int w = Align(_screen.width,  DIRTY_BLOCK_WIDTH);
 	const int h = Align(_screen.height, DIRTY_BLOCK_HEIGHT);
@@ -1463,6 +1518,8 @@ void SetDirtyBlocks(int left, int top, int right, int bottom)
  */
 void MarkWholeScreenDirty()
 {
+	InvalidateViewportMapTileColourCache();
+	InvalidateViewportTileSpriteCache();
 	SetDirtyBlocks(0, 0, _screen.width, _screen.height);
 }
 
@@ -42,6 +42,7 @@
 #include "object_base.h"
 #include "game/game.hpp"
 #include "error.h"
+#include "tick_timing.h"
 
 #include "table/strings.h"
 #include "table/industry_land.h"
@@ -1154,6 +1155,8 @@ static void ProduceIndustryGoods(Industry *i)
 
 void OnTick_Industry()
 {
+	TickTimer timer(TTP_INDUSTRIES);
+
 	if (_industry_sound_ctr != 0) {
 		_industry_sound_ctr++;
 
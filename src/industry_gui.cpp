@@ -2345,6 +2345,7 @@ struct IndustryCargoesWindow : public Window {
 		InvalidateWindowClassesData(WC_SMALLMAP, 0);
 
 		/* Notify viewports too. */
+		InvalidateViewportMapTileColourCache();
 		Window *w;
 		FOR_ALL_WINDOWS_FROM_BACK(w) {
 			if (w->viewport != NULL)
@@ -35,6 +35,8 @@
 #include "saveload/saveload.h"
 #include "3rdparty/cpp-btree/btree_set.h"
 #include "scope_info.h"
+#include "pathfinder/water_regions.h"
+#include "tick_timing.h"
 #include <deque>
 
 #include "table/strings.h"
@@ -500,6 +502,7 @@ void DoClearSquare(TileIndex tile)
 
 	MakeClear(tile, CLEAR_GRASS, _generating_world ? 3 : 0);
 	MarkTileDirtyByTile(tile);
+	InvalidateWaterRegion(tile);
 }
 
 /**
@@ -728,6 +731,8 @@ TileIndex _cur_tileloop_tile;
  */
 void RunTileLoop()
 {
+	TickTimer timer(TTP_TILE_LOOP);
+
 	/* The pseudorandom sequence of tiles is generated using a Galois linear feedback
 	 * shift register (LFSR). This allows a deterministic pseudorandom ordering, but
 	 * still with minimal state and fast iteration. */
@@ -1315,6 +1320,8 @@ void OnTick_LinkGraph();
 
 void CallLandscapeTick()
 {
+	TickTimer timer(TTP_LANDSCAPE);
+
 	OnTick_Town();
 	OnTick_Trees();
 	OnTick_Station();
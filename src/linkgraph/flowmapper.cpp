@@ -63,5 +63,5 @@ void FlowMapper::Run(LinkGraphJob &job) const
 		/* Clear paths. */
 		node.Paths().clear();
 	}
-	job.path_allocator.ResetArena();
+	job.ResetPathAllocators();
 }
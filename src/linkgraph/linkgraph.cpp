@@ -12,6 +12,7 @@
 #include "../stdafx.h"
 #include "../core/pool_func.hpp"
 #include "linkgraph.h"
+#include "../settings_type.h"
 
 #include "../safeguards.h"
 
@@ -291,3 +292,74 @@ void LinkGraph::Init(uint size)
 		for (uint j = 0; j < size; ++j) column[j].Init();
 	}
 }
+
+/**
+ * Quantise a value into logarithmic buckets with four buckets per power of two,
+ * so that small fluctuations of supplies and capacities don't change a job signature.
+ * Values below 4 get a bucket of their own; above that, the bucket starting at
+ * 2^n * (4 + k) / 4 is 2^n / 4 wide, so values in one bucket differ by less than 25%.
+ * @param value Value to be quantised.
+ * @return Bucket of the value.
+ */
+static inline uint QuantiseJobSignatureValue(uint value)
+{
+	if (value < 4) return value;
+	uint bit = FindLastBit(value);
+	return (bit << 2) | ((value >> (bit - 2)) & 3);
+}
+
+/**
+ * Mix a value into a job signature (FNV-1a on 32 bit words).
+ * @param signature Signature so far.
+ * @param value Value to be mixed in.
+ * @return New signature.
+ */
+static inline uint64 MixJobSignature(uint64 signature, uint32 value)
+{
+	return (signature ^ value) * 0x100000001B3ULL;
+}
+
+/**
+ * Calculate a signature of everything a link graph job spawned from this
+ * component right now would use as input: the nodes with their acceptance and
+ * quantised monthly supply, the edges with their quantised monthly capacity and
+ * restriction state, and the distribution settings. If the signature equals the
+ * one of the last job the result of a new job would be roughly the same, so the
+ * recalculation can be skipped.
+ * Skipping is not exact: supplies and capacities which changed within their
+ * quantisation bucket (see QuantiseJobSignatureValue), i.e. by less than 25%,
+ * leave the signature unchanged, and the flows of the last job are kept even
+ * though a new job would have distributed the cargo slightly differently.
+ * @param settings Link graph settings a new job would be run with.
+ * @return Job signature, never 0.
+ */
+uint64 LinkGraph::CalculateJobSignature(const LinkGraphSettings &settings) const
+{
+	uint64 signature = 0xCBF29CE484222325ULL;
+	signature = MixJobSignature(signature, settings.GetDistributionType(this->cargo));
+	signature = MixJobSignature(signature, settings.accuracy);
+	signature = MixJobSignature(signature, settings.demand_size);
+	signature = MixJobSignature(signature, settings.demand_distance);
+	signature = MixJobSignature(signature, settings.short_path_saturation);
+	signature = MixJobSignature(signature, this->Size());
+
+	for (NodeID from = 0; from < this->Size(); ++from) {
+		const BaseNode &node = this->nodes[from];
+		signature = MixJobSignature(signature, node.station);
+		signature = MixJobSignature(signature, node.xy);
+		signature = MixJobSignature(signature, node.demand > 0 ? 1 : 0);
+		signature = MixJobSignature(signature, QuantiseJobSignatureValue(this->Monthly(node.supply)));
+
+		const BaseEdge *row = this->edges[from];
+		for (NodeID to = row[from].next_edge; to != INVALID_NODE; to = row[to].next_edge) {
+			const BaseEdge &edge = row[to];
+			signature = MixJobSignature(signature, to);
+			signature = MixJobSignature(signature, QuantiseJobSignatureValue(this->Monthly(edge.capacity)));
+			signature = MixJobSignature(signature, (edge.last_unrestricted_update != INVALID_DATE ? 1 : 0) |
+					(edge.last_restricted_update != INVALID_DATE ? 2 : 0));
+		}
+		signature = MixJobSignature(signature, INVALID_NODE);
+	}
+
+	return signature != 0 ? signature : 1;
+}
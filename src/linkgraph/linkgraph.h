@@ -23,6 +23,8 @@
 
 struct SaveLoad;
 class LinkGraph;
+class LinkGraphJob;
+struct LinkGraphSettings;
 
 /**
  * Type of the pool for link graph components. Each station can be in at up to
@@ -459,12 +461,12 @@ public:
 	}
 
 	/** Bare constructor, only for save/load. */
-	LinkGraph() : cargo(INVALID_CARGO), last_compression(0) {}
+	LinkGraph() : cargo(INVALID_CARGO), last_compression(0), last_job_signature(0) {}
 	/**
 	 * Real constructor.
 	 * @param cargo Cargo the link graph is about.
 	 */
-	LinkGraph(CargoID cargo) : cargo(cargo), last_compression(_date) {}
+	LinkGraph(CargoID cargo) : cargo(cargo), last_compression(_date), last_job_signature(0) {}
 
 	void Init(uint size);
 	void ShiftDates(int interval);
@@ -529,17 +531,34 @@ public:
 		return size_squared * FindLastBit(size_squared * size_squared); // N^2 * 4log_2(N)
 	}
 
+	uint64 CalculateJobSignature(const LinkGraphSettings &settings) const;
+
+	/**
+	 * Get the signature of the inputs of the last job spawned for this link graph.
+	 * @return Job signature, or 0 if none was recorded.
+	 */
+	inline uint64 LastJobSignature() const { return this->last_job_signature; }
+
+	/**
+	 * Set the signature of the inputs of the last job spawned for this link graph.
+	 * @param signature New job signature.
+	 */
+	inline void SetLastJobSignature(uint64 signature) { this->last_job_signature = signature; }
+
 protected:
 	friend class LinkGraph::ConstNode;
 	friend class LinkGraph::Node;
 	friend const SaveLoad *GetLinkGraphDesc();
 	friend const SaveLoad *GetLinkGraphJobDesc();
 	friend void SaveLoad_LinkGraph(LinkGraph &lg);
+	friend void Save_LinkGraphJobGraph(LinkGraphJob &lgj);
+	friend class LinkGraphJob;
 
 	CargoID cargo;         ///< Cargo of this component's link graph.
 	Date last_compression; ///< Last time the capacities and supplies were compressed.
 	NodeVector nodes;      ///< Nodes in the component.
 	EdgeMatrix edges;      ///< Edges in the component.
+	uint64 last_job_signature; ///< Signature of the inputs of the last job spawned, see CalculateJobSignature.
 };
 
 #define FOR_ALL_LINK_GRAPHS(var) FOR_ALL_ITEMS_FROM(LinkGraph, link_graph_index, var, 0)
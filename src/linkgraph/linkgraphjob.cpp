@@ -28,6 +28,8 @@ INSTANTIATE_POOL_METHODS(LinkGraphJob)
  */
 /* static */ Path *Path::invalid_path = new Path(INVALID_NODE, true);
 
+/* static */ const LinkGraph::BaseEdge LinkGraphJob::Edge::invalid_edge = { 0, 0, INVALID_DATE, INVALID_DATE, INVALID_NODE };
+
 static DateTicks GetLinkGraphJobJoinDateTicks(uint duration_multiplier)
 {
 	DateTicks ticks = _settings_game.linkgraph.recalc_time * DAY_TICKS * duration_multiplier;
@@ -44,15 +46,64 @@ static DateTicks GetLinkGraphJobJoinDateTicks(uint duration_multiplier)
  * @param orig Original LinkGraph to be copied.
  */
 LinkGraphJob::LinkGraphJob(const LinkGraph &orig, uint duration_multiplier) :
-		/* Copying the link graph here also copies its index member.
-		 * This is on purpose. */
-		link_graph(orig),
+		link_graph(orig.cargo),
 		settings(_settings_game.linkgraph),
 		join_date_ticks(GetLinkGraphJobJoinDateTicks(duration_multiplier)),
 		start_date_ticks((_date * DAY_TICKS) + _date_fract),
 		job_completed(false),
 		abort_job(false)
 {
+	/* Copy the index as well. This is on purpose. The edges are only copied
+	 * into the compressed edge array, not into the job's link graph. */
+	this->link_graph.index = orig.index;
+	this->link_graph.last_compression = orig.last_compression;
+	this->link_graph.nodes = orig.nodes;
+	this->CopyEdges(orig);
+}
+
+/**
+ * Copy the edges of a link graph into the compressed edge array of the job.
+ * The edges of each node are kept in the order of the next_edge list, so
+ * that they are iterated in the same order as in the link graph. A separate
+ * index sorted by destination allows looking up single edges quickly.
+ * @param lg Link graph to copy the edges from.
+ */
+void LinkGraphJob::CopyEdges(const LinkGraph &lg)
+{
+	uint size = lg.Size();
+	this->edges.clear();
+	this->edge_offsets.resize(size + 1);
+	for (NodeID from = 0; from < size; ++from) {
+		this->edge_offsets[from] = (uint)this->edges.size();
+		const LinkGraph::BaseEdge *from_edges = lg.edges[from];
+		for (NodeID to = from_edges[from].next_edge; to != INVALID_NODE; to = from_edges[to].next_edge) {
+			EdgeAnnotation anno;
+			anno.base = from_edges[to];
+			anno.to = to;
+			anno.flow = 0;
+			this->edges.push_back(anno);
+		}
+	}
+	this->edge_offsets[size] = (uint)this->edges.size();
+	this->edges.shrink_to_fit();
+
+	this->edges_by_dest.resize(this->edges.size());
+	for (uint i = 0; i < this->edges.size(); ++i) this->edges_by_dest[i] = i;
+	const EdgeAnnotation *edges = this->edges.data();
+	for (NodeID from = 0; from < size; ++from) {
+		std::sort(this->edges_by_dest.begin() + this->edge_offsets[from], this->edges_by_dest.begin() + this->edge_offsets[from + 1],
+				[edges](uint a, uint b) { return edges[a].to < edges[b].to; });
+	}
+}
+
+/**
+ * Move the edges of the link graph of a loaded job into the compressed edge
+ * array and free the edge matrix of the link graph. Only use this for save/load.
+ */
+void LinkGraphJob::CompressEdgesAfterLoad()
+{
+	this->CopyEdges(this->link_graph);
+	this->link_graph.edges.Reset();
 }
 
 /**
@@ -66,6 +117,16 @@ void LinkGraphJob::EraseFlows(NodeID from)
 	}
 }
 
+/**
+ * Release all paths allocated by any of the path allocators of this job.
+ */
+void LinkGraphJob::ResetPathAllocators()
+{
+	for (uint i = 0; i < PATH_ALLOCATOR_COUNT; i++) {
+		this->path_allocators[i].ResetArena();
+	}
+}
+
 void LinkGraphJob::SetJobGroup(std::shared_ptr<LinkGraphJobGroup> group)
 {
 	this->group = std::move(group);
@@ -123,7 +184,7 @@ void LinkGraphJob::FinaliseJob()
 		FlowStatMap &flows = from.Flows();
 
 		for (EdgeIterator it(from.Begin()); it != from.End(); ++it) {
-			if (from[it->first].Flow() == 0) continue;
+			if (it->second.Flow() == 0) continue;
 			StationID to = (*this)[it->first].Station();
 			Station *st2 = Station::GetIfValid(to);
 			if (st2 == NULL || st2->goods[this->Cargo()].link_graph != this->link_graph.index ||
@@ -221,34 +282,20 @@ void LinkGraphJob::AbortJob()
 }
 
 /**
- * Initialize the link graph job: Resize nodes and edges and populate them.
- * This is done after the constructor so that we can do it in the calculation
- * thread without delaying the main game.
+ * Initialize the link graph job: Resize nodes and populate them. The edges
+ * are already set up by the constructor, which only needs to walk the actual
+ * edges of the link graph. This is done after the constructor so that we can
+ * do it in the calculation thread without delaying the main game.
  */
 void LinkGraphJob::Init()
 {
 	uint size = this->Size();
 	this->nodes.resize(size);
-	this->edges.Resize(size, size);
 	for (uint i = 0; i < size; ++i) {
-		this->nodes[i].Init(this->link_graph[i].Supply());
-		EdgeAnnotation *node_edges = this->edges[i];
-		for (uint j = 0; j < size; ++j) {
-			node_edges[j].Init();
-		}
+		this->nodes[i].Init(this->link_graph.nodes[i].supply);
 	}
 }
 
-/**
- * Initialize a linkgraph job edge.
- */
-void LinkGraphJob::EdgeAnnotation::Init()
-{
-	this->demand = 0;
-	this->flow = 0;
-	this->unsatisfied_demand = 0;
-}
-
 /**
  * Initialize a Linkgraph job node. The underlying memory is expected to be
  * freshly allocated, without any constructors having been called.
@@ -293,6 +340,7 @@ uint Path::AddFlow(uint new_flow, LinkGraphJob &job, uint max_saturation)
 {
 	if (this->parent != NULL) {
 		LinkGraphJob::Edge edge = job[this->parent->node][this->node];
+		if (!edge.IsValid()) return 0;
 		if (max_saturation != UINT_MAX) {
 			uint usable_cap = edge.Capacity() * max_saturation / 100;
 			if (usable_cap > edge.Flow()) {
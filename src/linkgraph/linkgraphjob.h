@@ -14,9 +14,11 @@
 
 #include "../thread/thread.h"
 #include "../core/dyn_arena_alloc.hpp"
+#include "../3rdparty/cpp-btree/btree_map.h"
 #include "linkgraph.h"
 #include <vector>
 #include <memory>
+#include <algorithm>
 
 class LinkGraphJob;
 class Path;
@@ -34,15 +36,64 @@ extern LinkGraphJobPool _link_graph_job_pool;
 class LinkGraphJob : public LinkGraphJobPool::PoolItem<&_link_graph_job_pool>{
 private:
 	/**
-	 * Annotation for a link graph edge.
+	 * Annotation for a link graph edge. The edges of all nodes are stored in
+	 * one array, grouped by source node (compressed sparse row). This avoids
+	 * keeping a matrix of all node pairs for the usually very sparse graph.
 	 */
 	struct EdgeAnnotation {
+		LinkGraph::BaseEdge base; ///< Copy of the link graph edge.
+		NodeID to;                ///< Destination of the edge.
+		uint flow;                ///< Planned flow over this edge.
+	};
+
+public:
+	/**
+	 * Demand from one node to another one. Demands are only kept for the pairs
+	 * of nodes which actually have some, in the annotation of the supplying node.
+	 */
+	struct DemandAnnotation {
 		uint demand;             ///< Transport demand between the nodes.
-		uint unsatisfied_demand; ///< Demand over this edge that hasn't been satisfied yet.
-		uint flow;               ///< Planned flow over this edge.
-		void Init();
+		uint unsatisfied_demand; ///< Demand between the nodes that hasn't been satisfied yet.
+
+		DemandAnnotation() : demand(0), unsatisfied_demand(0) {}
+
+		/**
+		 * Get the transport demand between the nodes.
+		 * @return Demand.
+		 */
+		uint Demand() const { return this->demand; }
+
+		/**
+		 * Get the transport demand that hasn't been satisfied by flows, yet.
+		 * @return Unsatisfied demand.
+		 */
+		uint UnsatisfiedDemand() const { return this->unsatisfied_demand; }
+
+		/**
+		 * Add some (not yet satisfied) demand.
+		 * @param demand Demand to be added.
+		 */
+		void AddDemand(uint demand)
+		{
+			this->demand += demand;
+			this->unsatisfied_demand += demand;
+		}
+
+		/**
+		 * Satisfy some demand.
+		 * @param demand Demand to be satisfied.
+		 */
+		void SatisfyDemand(uint demand)
+		{
+			assert(demand <= this->unsatisfied_demand);
+			this->unsatisfied_demand -= demand;
+		}
 	};
 
+	/** Demands from a node, by destination node. Iterates in order of the destination. */
+	typedef btree::btree_map<NodeID, DemandAnnotation> DemandMap;
+
+private:
 	/**
 	 * Annotation for a link graph node.
 	 */
@@ -50,138 +101,182 @@ private:
 		uint undelivered_supply; ///< Amount of supply that hasn't been distributed yet.
 		PathList paths;          ///< Paths through this node, sorted so that those with flow == 0 are in the back.
 		FlowStatMap flows;       ///< Planned flows to other nodes.
+		DemandMap demands;       ///< Demands to other nodes.
 		void Init(uint supply);
 	};
 
 	typedef std::vector<NodeAnnotation> NodeAnnotationVector;
-	typedef SmallMatrix<EdgeAnnotation> EdgeAnnotationMatrix;
+	typedef std::vector<EdgeAnnotation> EdgeAnnotationVector;
 
 	friend const SaveLoad *GetLinkGraphJobDesc();
 	friend void GetLinkGraphJobDayLengthScaleAfterLoad(LinkGraphJob *lgj);
+	friend void Save_LinkGraphJobGraph(LinkGraphJob &lgj);
 	friend class LinkGraphSchedule;
 	friend class LinkGraphJobGroup;
 
 protected:
-	const LinkGraph link_graph;       ///< Link graph to by analyzed. Is copied when job is started and mustn't be modified later.
+	LinkGraph link_graph;             ///< Nodes of the link graph to by analyzed, the edges are in #edges. Is copied when job is started and mustn't be modified later.
 	std::shared_ptr<LinkGraphJobGroup> group; ///< JOb group thread the job is running in or NULL if it's running in the main thread.
 	const LinkGraphSettings settings; ///< Copy of _settings_game.linkgraph at spawn time.
 	DateTicks join_date_ticks;        ///< Date when the job is to be joined.
 	DateTicks start_date_ticks;       ///< Date when the job was started.
 	NodeAnnotationVector nodes;       ///< Extra node data necessary for link graph calculation.
-	EdgeAnnotationMatrix edges;       ///< Extra edge data necessary for link graph calculation.
+	EdgeAnnotationVector edges;       ///< Edges of the link graph with the extra data necessary for link graph calculation, grouped by source node.
+	std::vector<uint> edge_offsets;   ///< Index of the first edge of each node in #edges, followed by the total number of edges.
+	std::vector<uint> edges_by_dest;  ///< Indices into #edges, with the same ranges per node as #edges but sorted by destination.
 	bool job_completed;               ///< Is the job still running. This is accessed by multiple threads and is permitted to be spuriously incorrect.
 	bool abort_job;                   ///< Abort the job at the next available opportunity. This is accessed by multiple threads.
 
+	void CopyEdges(const LinkGraph &lg);
 	void EraseFlows(NodeID from);
 	void JoinThread();
 	void SetJobGroup(std::shared_ptr<LinkGraphJobGroup> group);
 
 public:
 
-	DynUniformArenaAllocator path_allocator; ///< Arena allocator used for paths
+	/** Number of path allocators; this is also the number of MCF Dijkstra runs which may be in flight at the same time. */
+	static const uint PATH_ALLOCATOR_COUNT = 16;
+
+	DynUniformArenaAllocator path_allocators[PATH_ALLOCATOR_COUNT]; ///< Arena allocators used for paths, one per concurrent Dijkstra run
+
+	void ResetPathAllocators();
 
 	bool IsJobAborted() const;
 
 	/**
-	 * A job edge. Wraps a link graph edge and an edge annotation. The
+	 * A job edge. Wraps a link graph edge and its annotation. The
 	 * annotation can be modified, the edge is constant.
 	 */
 	class Edge : public LinkGraph::ConstEdge {
 	private:
-		EdgeAnnotation &anno; ///< Annotation being wrapped.
+		static const LinkGraph::BaseEdge invalid_edge; ///< Edge without capacity, wrapped by invalid edges.
+		EdgeAnnotation *anno; ///< Annotation being wrapped, or NULL if the nodes are not connected.
 	public:
 		/**
 		 * Constructor.
-		 * @param edge Link graph edge to be wrapped.
-		 * @param anno Annotation to be wrapped.
+		 * @param anno Annotation to be wrapped, including the edge.
 		 */
-		Edge(const LinkGraph::BaseEdge &edge, EdgeAnnotation &anno) :
-				LinkGraph::ConstEdge(edge), anno(anno) {}
+		Edge(EdgeAnnotation &anno) : LinkGraph::ConstEdge(anno.base), anno(&anno) {}
 
 		/**
-		 * Get the transport demand between end the points of the edge.
-		 * @return Demand.
+		 * Constructor for an invalid edge between two nodes which are not
+		 * connected. It has neither capacity nor flow and can't take any flow.
 		 */
-		uint Demand() const { return this->anno.demand; }
+		Edge() : LinkGraph::ConstEdge(invalid_edge), anno(NULL) {}
 
 		/**
-		 * Get the transport demand that hasn't been satisfied by flows, yet.
-		 * @return Unsatisfied demand.
+		 * Check if this edge actually exists.
+		 * @return If the nodes are connected.
 		 */
-		uint UnsatisfiedDemand() const { return this->anno.unsatisfied_demand; }
+		bool IsValid() const { return this->anno != NULL; }
 
 		/**
 		 * Get the total flow on the edge.
 		 * @return Flow.
 		 */
-		uint Flow() const { return this->anno.flow; }
+		uint Flow() const { return this->anno != NULL ? this->anno->flow : 0; }
 
 		/**
-		 * Add some flow.
+		 * Add some flow. The edge has to be valid.
 		 * @param flow Flow to be added.
 		 */
-		void AddFlow(uint flow) { this->anno.flow += flow; }
+		void AddFlow(uint flow)
+		{
+			assert(this->IsValid());
+			this->anno->flow += flow;
+		}
 
 		/**
-		 * Remove some flow.
+		 * Remove some flow. The edge has to be valid.
 		 * @param flow Flow to be removed.
 		 */
 		void RemoveFlow(uint flow)
 		{
-			assert(flow <= this->anno.flow);
-			this->anno.flow -= flow;
+			assert(this->IsValid());
+			assert(flow <= this->anno->flow);
+			this->anno->flow -= flow;
 		}
+	};
+
+	/**
+	 * Iterator for job edges. The edges of a node are adjacent in the edge
+	 * array, so this simply walks through it.
+	 */
+	class EdgeIterator {
+	private:
+		EdgeAnnotation *current; ///< Edge currently pointed to.
 
 		/**
-		 * Add some (not yet satisfied) demand.
-		 * @param demand Demand to be added.
+		 * A "fake" pointer to enable operator-> on temporaries, see
+		 * LinkGraph::BaseEdgeIterator::FakePointer.
 		 */
-		void AddDemand(uint demand)
+		class FakePointer : public SmallPair<NodeID, Edge> {
+		public:
+			/**
+			 * Construct a fake pointer from a pair of NodeID and edge.
+			 * @param pair Pair to be "pointed" to (in fact shallow-copied).
+			 */
+			FakePointer(const SmallPair<NodeID, Edge> &pair) : SmallPair<NodeID, Edge>(pair) {}
+
+			/**
+			 * Retrieve the pair by operator->.
+			 * @return Pair being "pointed" to.
+			 */
+			SmallPair<NodeID, Edge> *operator->() { return this; }
+		};
+
+	public:
+		/**
+		 * Constructor.
+		 * @param current Edge to start at.
+		 */
+		EdgeIterator(EdgeAnnotation *current) : current(current) {}
+
+		/**
+		 * Prefix-increment.
+		 * @return This.
+		 */
+		EdgeIterator &operator++()
 		{
-			this->anno.demand += demand;
-			this->anno.unsatisfied_demand += demand;
+			++this->current;
+			return *this;
 		}
 
 		/**
-		 * Satisfy some demand.
-		 * @param demand Demand to be satisfied.
+		 * Postfix-increment.
+		 * @return Version of this before increment.
 		 */
-		void SatisfyDemand(uint demand)
+		EdgeIterator operator++(int)
 		{
-			assert(demand <= this->anno.unsatisfied_demand);
-			this->anno.unsatisfied_demand -= demand;
+			return EdgeIterator(this->current++);
 		}
-	};
 
-	/**
-	 * Iterator for job edges.
-	 */
-	class EdgeIterator : public LinkGraph::BaseEdgeIterator<const LinkGraph::BaseEdge, Edge, EdgeIterator> {
-		EdgeAnnotation *base_anno; ///< Array of annotations to be (indirectly) iterated.
-	public:
 		/**
-		 * Constructor.
-		 * @param base Array of edges to be iterated.
-		 * @param base_anno Array of annotations to be iterated.
-		 * @param current Start offset of iteration.
+		 * Compare with some other edge iterator.
+		 * @param other Other iterator.
+		 * @return If both point to the same edge.
+		 */
+		bool operator==(const EdgeIterator &other) const { return this->current == other.current; }
+
+		/**
+		 * Compare for inequality with some other edge iterator.
+		 * @param other Other iterator.
+		 * @return If the iterators point to different edges.
 		 */
-		EdgeIterator(const LinkGraph::BaseEdge *base, EdgeAnnotation *base_anno, NodeID current) :
-				LinkGraph::BaseEdgeIterator<const LinkGraph::BaseEdge, Edge, EdgeIterator>(base, current),
-				base_anno(base_anno) {}
+		bool operator!=(const EdgeIterator &other) const { return this->current != other.current; }
 
 		/**
 		 * Dereference.
-		 * @return Pair of the edge currently pointed to and the ID of its
-		 *         other end.
+		 * @return Pair of the ID of the other end of the edge currently
+		 *         pointed to and the edge.
 		 */
 		SmallPair<NodeID, Edge> operator*() const
 		{
-			return SmallPair<NodeID, Edge>(this->current, Edge(this->base[this->current], this->base_anno[this->current]));
+			return SmallPair<NodeID, Edge>(this->current->to, Edge(*this->current));
 		}
 
 		/**
-		 * Dereference. Has to be repeated here as operator* is different than
-		 * in LinkGraph::EdgeWrapper.
+		 * Dereference.
 		 * @return Fake pointer to pair of NodeID/Edge.
 		 */
 		FakePointer operator->() const {
@@ -193,10 +288,14 @@ public:
 	 * Link graph job node. Wraps a constant link graph node and a modifiable
 	 * node annotation.
 	 */
-	class Node : public LinkGraph::ConstNode {
+	class Node : public LinkGraph::NodeWrapper<const LinkGraph::BaseNode, const LinkGraph::BaseEdge> {
 	private:
 		NodeAnnotation &node_anno;  ///< Annotation being wrapped.
-		EdgeAnnotation *edge_annos; ///< Edge annotations belonging to this node.
+		EdgeAnnotation *edges;       ///< All edges of the job.
+		EdgeAnnotation *edges_begin; ///< First edge starting at this node.
+		EdgeAnnotation *edges_end;   ///< End of the edges starting at this node.
+		const uint *dest_begin;      ///< First index of the edges starting at this node, sorted by destination.
+		const uint *dest_end;        ///< End of the indices of the edges starting at this node.
 	public:
 
 		/**
@@ -205,31 +304,42 @@ public:
 		 * @param node ID of the node.
 		 */
 		Node (LinkGraphJob *lgj, NodeID node) :
-			LinkGraph::ConstNode(&lgj->link_graph, node),
-			node_anno(lgj->nodes[node]), edge_annos(lgj->edges[node])
+			LinkGraph::NodeWrapper<const LinkGraph::BaseNode, const LinkGraph::BaseEdge>(lgj->link_graph.nodes[node], NULL, node),
+			node_anno(lgj->nodes[node]),
+			edges(lgj->edges.data()),
+			edges_begin(lgj->edges.data() + lgj->edge_offsets[node]),
+			edges_end(lgj->edges.data() + lgj->edge_offsets[node + 1]),
+			dest_begin(lgj->edges_by_dest.data() + lgj->edge_offsets[node]),
+			dest_end(lgj->edges_by_dest.data() + lgj->edge_offsets[node + 1])
 		{}
 
 		/**
 		 * Retrieve an edge starting at this node. Mind that this returns an
-		 * object, not a reference.
+		 * object, not a reference. If there is no such edge an invalid one is
+		 * returned, see Edge::IsValid.
 		 * @param to Remote end of the edge.
 		 * @return Edge between this node and "to".
 		 */
-		Edge operator[](NodeID to) const { return Edge(this->edges[to], this->edge_annos[to]); }
+		Edge operator[](NodeID to) const
+		{
+			const EdgeAnnotation *edges = this->edges;
+			const uint *index = std::lower_bound(this->dest_begin, this->dest_end, to,
+					[edges](uint i, NodeID to) { return edges[i].to < to; });
+			if (index == this->dest_end || this->edges[*index].to != to) return Edge();
+			return Edge(this->edges[*index]);
+		}
 
 		/**
-		 * Iterator for the "begin" of the edge array. Only edges with capacity
-		 * are iterated. The others are skipped.
+		 * Iterator for the "begin" of the edges starting at this node.
 		 * @return Iterator pointing to the first edge.
 		 */
-		EdgeIterator Begin() const { return EdgeIterator(this->edges, this->edge_annos, index); }
+		EdgeIterator Begin() const { return EdgeIterator(this->edges_begin); }
 
 		/**
-		 * Iterator for the "end" of the edge array. Only edges with capacity
-		 * are iterated. The others are skipped.
+		 * Iterator for the "end" of the edges starting at this node.
 		 * @return Iterator pointing beyond the last edge.
 		 */
-		EdgeIterator End() const { return EdgeIterator(this->edges, this->edge_annos, INVALID_NODE); }
+		EdgeIterator End() const { return EdgeIterator(this->edges_end); }
 
 		/**
 		 * Get amount of supply that hasn't been delivered, yet.
@@ -263,14 +373,21 @@ public:
 		const PathList &Paths() const { return this->node_anno.paths; }
 
 		/**
-		 * Deliver some supply, adding demand to the respective edge.
+		 * Get the demands from this node to other nodes.
+		 * @return Demands, by destination node.
+		 */
+		DemandMap &Demands() { return this->node_anno.demands; }
+
+		/**
+		 * Deliver some supply, adding demand to the respective node pair.
 		 * @param to Destination for supply.
 		 * @param amount Amount of supply to be delivered.
 		 */
 		void DeliverSupply(NodeID to, uint amount)
 		{
+			if (amount == 0) return;
 			this->node_anno.undelivered_supply -= amount;
-			(*this)[to].AddDemand(amount);
+			this->node_anno.demands[to].AddDemand(amount);
 		}
 	};
 
@@ -357,6 +474,8 @@ public:
 	 * @return Link graph.
 	 */
 	inline const LinkGraph &Graph() const { return this->link_graph; }
+
+	void CompressEdgesAfterLoad();
 };
 
 #define FOR_ALL_LINK_GRAPH_JOBS(var) FOR_ALL_ITEMS_FROM(LinkGraphJob, link_graph_job_index, var, 0)
@@ -19,5 +19,7 @@
 typedef LinkGraphJob::Node Node;
 typedef LinkGraphJob::Edge Edge;
 typedef LinkGraphJob::EdgeIterator EdgeIterator;
+typedef LinkGraphJob::DemandAnnotation DemandAnnotation;
+typedef LinkGraphJob::DemandMap DemandMap;
 
 #endif /* LINKGRAPHJOB_BASE_H */
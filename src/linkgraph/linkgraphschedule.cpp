@@ -16,6 +16,7 @@
 #include "mcf.h"
 #include "flowmapper.h"
 #include "../command_func.h"
+#include "../tick_timing.h"
 #include <algorithm>
 
 #include "../safeguards.h"
@@ -69,6 +70,18 @@ void LinkGraphSchedule::SpawnNext()
 		LinkGraph *lg = this->schedule.front();
 		assert(lg == LinkGraph::Get(lg->index));
 		this->schedule.pop_front();
+		if (_settings_game.linkgraph.recalc_incremental) {
+			uint64 signature = lg->CalculateJobSignature(_settings_game.linkgraph);
+			if (signature == lg->LastJobSignature()) {
+				/* Nothing relevant changed since the last job, keep the flows it produced. */
+				schedule_to_back.push_back(lg);
+				DEBUG(linkgraph, 3, "LinkGraphSchedule::SpawnNext(): Skipping unchanged job: id: %u, nodes: %u", lg->index, lg->Size());
+				continue;
+			}
+			lg->SetLastJobSignature(signature);
+		} else {
+			lg->SetLastJobSignature(0);
+		}
 		uint64 cost = lg->CalculateCostEstimate();
 		used_budget += cost;
 		if (LinkGraphJob::CanAllocateItem()) {
@@ -142,7 +155,7 @@ void LinkGraphSchedule::JoinNext()
 
 /**
  * Run all handlers for the given Job. This method is tailored to
- * ThreadObject::New.
+ * ThreadPool::Submit.
  * @param j Pointer to a link graph job.
  */
 /* static */ void LinkGraphSchedule::Run(void *j)
@@ -232,19 +245,16 @@ LinkGraphJobGroup::LinkGraphJobGroup(constructor_token token, std::vector<LinkGr
 	jobs(std::move(jobs)) { }
 
 void LinkGraphJobGroup::SpawnThread() {
-	ThreadObject *t = nullptr;
-
 	/**
-	 * Spawn a thread if possible and run the link graph job in the thread. If
-	 * that's not possible run the job right now in the current thread.
+	 * Run the link graph job in the thread pool if possible. If that's not
+	 * possible run the job right now in the current thread.
 	 */
-	if (ThreadObject::New(&(LinkGraphJobGroup::Run), this, &t, "ottd:linkgraph")) {
-		this->thread.reset(t);
+	if (ThreadPool::Submit(&(LinkGraphJobGroup::Run), this, &this->task, TPTF_LONG, "ottd:linkgraph")) {
 		for (auto &it : this->jobs) {
 			it->SetJobGroup(this->shared_from_this());
 		}
 	} else {
-		this->thread.reset();
+		this->task.reset();
 		/* Of course this will hang a bit.
 		 * On the other hand, if you want to play games which make this hang noticably
 		 * on a platform without threads then you'll probably get other problems first.
@@ -257,14 +267,14 @@ void LinkGraphJobGroup::SpawnThread() {
 }
 
 void LinkGraphJobGroup::JoinThread() {
-	if (!this->thread || this->joined_thread) return;
-	this->thread->Join();
+	if (!this->task || this->joined_thread) return;
+	this->task->Join();
 	this->joined_thread = true;
 }
 
 /**
  * Run all jobs for the given LinkGraphJobGroup. This method is tailored to
- * ThreadObject::New.
+ * ThreadPool::Submit.
  * @param j Pointer to a LinkGraphJobGroup.
  */
 /* static */ void LinkGraphJobGroup::Run(void *group)
@@ -339,6 +349,8 @@ void StateGameLoop_LinkGraphPauseControl()
  */
 void OnTick_LinkGraph()
 {
+	TickTimer timer(TTP_LINK_GRAPH);
+
 	int offset;
 	int interval;
 	if (!_settings_game.linkgraph.recalc_not_scaled_by_daylength || _settings_game.economy.day_length_factor == 1) {
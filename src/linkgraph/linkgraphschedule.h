@@ -12,7 +12,7 @@
 #ifndef LINKGRAPHSCHEDULE_H
 #define LINKGRAPHSCHEDULE_H
 
-#include "../thread/thread.h"
+#include "../thread/thread_pool.h"
 #include "linkgraph.h"
 #include <memory>
 
@@ -86,7 +86,7 @@ class LinkGraphJobGroup : public std::enable_shared_from_this<LinkGraphJobGroup>
 
 private:
 	bool joined_thread = false;              ///< True if thread has already been joined
-	std::unique_ptr<ThreadObject> thread;    ///< Thread the job group is running in or NULL if it's running in the main thread.
+	ThreadPoolHandle task;                   ///< Thread pool task the job group is running in or NULL if it's running in the main thread.
 	const std::vector<LinkGraphJob *> jobs;  ///< The set of jobs in this job set
 
 private:
@@ -3,25 +3,32 @@
 #include "../stdafx.h"
 #include "../core/math_func.hpp"
 #include "mcf.h"
+#include "../thread/thread_pool.h"
 #include "../3rdparty/cpp-btree/btree_map.h"
-#include <set>
 
 #include "../safeguards.h"
 
 typedef btree::btree_map<NodeID, Path *> PathViaMap;
 
+/**
+ * Minimum size of a link graph for the Dijkstra runs of the MCF passes to be
+ * batched and spread over the thread pool. This must not depend on anything
+ * local, like the number of processor cores, as the batching changes the result.
+ */
+static const uint MCF_BATCH_MIN_NODES = 128;
+
 /**
  * This is a wrapper around Tannotation* which also stores a cache of GetAnnotation() and GetNode()
- * to remove the need dereference the Tannotation* pointer when sorting/inseting/erasing in MultiCommodityFlow::Dijkstra::AnnoSet
+ * to remove the need dereference the Tannotation* pointer when sifting items in MultiCommodityFlow::Dijkstra's AnnoHeap
  */
 template<typename Tannotation>
-class AnnoSetItem {
+class AnnoHeapItem {
 public:
 	Tannotation *anno_ptr;
 	typename Tannotation::AnnotationValueType cached_annotation;
 	NodeID node_id;
 
-	AnnoSetItem(Tannotation *anno) : anno_ptr(anno), cached_annotation(anno->GetAnnotation()), node_id(anno->GetNode()) {}
+	AnnoHeapItem(Tannotation *anno) : anno_ptr(anno), cached_annotation(anno->GetAnnotation()), node_id(anno->GetNode()) {}
 };
 
 /**
@@ -54,10 +61,10 @@ public:
 	inline void UpdateAnnotation() { }
 
 	/**
-	 * Comparator for std containers.
+	 * Comparator for AnnoHeap.
 	 */
 	struct Comparator {
-		bool operator()(const AnnoSetItem<DistanceAnnotation> &x, const AnnoSetItem<DistanceAnnotation> &y) const;
+		bool operator()(const AnnoHeapItem<DistanceAnnotation> &x, const AnnoHeapItem<DistanceAnnotation> &y) const;
 	};
 };
 
@@ -97,10 +104,10 @@ public:
 	}
 
 	/**
-	 * Comparator for std containers.
+	 * Comparator for AnnoHeap.
 	 */
 	struct Comparator {
-		bool operator()(const AnnoSetItem<CapacityAnnotation> &x, const AnnoSetItem<CapacityAnnotation> &y) const;
+		bool operator()(const AnnoHeapItem<CapacityAnnotation> &x, const AnnoHeapItem<CapacityAnnotation> &y) const;
 	};
 };
 
@@ -121,7 +128,7 @@ public:
 	 * @param job Job to iterate on.
 	 */
 	GraphEdgeIterator(LinkGraphJob &job) : job(job),
-		i(NULL, NULL, INVALID_NODE), end(NULL, NULL, INVALID_NODE)
+		i(NULL), end(NULL)
 	{}
 
 	/**
@@ -263,96 +270,126 @@ bool CapacityAnnotation::IsBetter(const CapacityAnnotation *base, uint cap,
 	}
 }
 
-#ifdef CUSTOM_ALLOCATOR
 /**
- * Storage for AnnoSetAllocator instances
+ * Indexed d-ary heap of annotations for MultiCommodityFlow::Dijkstra, ordered
+ * by Tannotation::Comparator. As that comparator is a strict total order the
+ * nodes are popped in exactly the same order as from a sorted set.
+ * The position of each node in the heap is tracked, so that an annotation can
+ * be moved to its new place in O(log n) after it has been changed, without
+ * any allocations.
+ * @tparam Tannotation Annotation to be used.
  */
-struct AnnoSetAllocatorStore {
-	std::vector<void *> used_blocks;
-	void *current_block;
-	size_t next_position;
-	void *last_freed;
+template<class Tannotation>
+class AnnoHeap {
+	static const uint ARITY = 4;                  ///< Number of children of each heap item.
+	static const uint NOT_IN_HEAP = UINT_MAX;     ///< Position of nodes which are not in the heap.
 
-	AnnoSetAllocatorStore() : current_block(NULL), next_position(0), last_freed(NULL) {}
+	typedef AnnoHeapItem<Tannotation> Item;
 
-	~AnnoSetAllocatorStore()
+	std::vector<Item> items;     ///< The heap itself.
+	std::vector<uint> positions; ///< Position of each node in #items, or NOT_IN_HEAP.
+	typename Tannotation::Comparator comp; ///< Comparator, returns true if the first item has to be popped before the second.
+
+	/**
+	 * Put an item at a position and update its position index.
+	 * @param pos Position to put the item at.
+	 * @param item Item to be put there.
+	 */
+	inline void Place(uint pos, const Item &item)
 	{
-		for (std::vector<void *>::iterator i = used_blocks.begin(); i != used_blocks.end(); ++i) {
-			free(*i);
-		}
+		this->items[pos] = item;
+		this->positions[item.node_id] = pos;
 	}
-};
 
-/**
- * Custom allocator specifically for use with MultiCommodityFlow::Dijkstra::AnnoSet
- * This allocates RB-set nodes in contiguous blocks, and frees all allocated nodes when destructed
- * If a node is deallocated, it is returned in the next allocation, this is so that the same node
- * can be re-used across a call to Path::Fork
- */
-template<class Ttype>
-struct AnnoSetAllocator {
-	static const size_t block_size = 1024;
-
-	AnnoSetAllocatorStore &store;
-
-	void NewBlock()
+	/**
+	 * Move an item towards the top of the heap until the heap property holds.
+	 * @param pos Current position of the item.
+	 * @param item The item.
+	 */
+	void SiftUp(uint pos, const Item &item)
 	{
-		store.current_block = MallocT<Ttype>(block_size);
-		store.next_position = 0;
-		store.used_blocks.push_back(store.current_block);
+		while (pos > 0) {
+			uint parent = (pos - 1) / ARITY;
+			if (!this->comp(item, this->items[parent])) break;
+			this->Place(pos, this->items[parent]);
+			pos = parent;
+		}
+		this->Place(pos, item);
 	}
 
-	typedef Ttype value_type;
-
-	template<typename Tother>
-	struct rebind {
-		typedef AnnoSetAllocator<Tother> other;
-	};
-
-	AnnoSetAllocator(AnnoSetAllocatorStore &store) : store(store) {}
-
-	template<typename Tother>
-	AnnoSetAllocator(const AnnoSetAllocator<Tother> &other) : store(other.store) {}
-
-	Ttype* allocate(size_t n)
+	/**
+	 * Move an item towards the bottom of the heap until the heap property holds.
+	 * @param pos Current position of the item.
+	 * @param item The item.
+	 */
+	void SiftDown(uint pos, const Item &item)
 	{
-		if (store.current_block == NULL) NewBlock();
-
-		assert(n == 1);
-		if (store.last_freed != NULL) {
-			Ttype* out = static_cast<Ttype*>(store.last_freed);
-			store.last_freed = NULL;
-			return out;
+		uint size = (uint)this->items.size();
+		for (;;) {
+			uint first_child = pos * ARITY + 1;
+			if (first_child >= size) break;
+			uint last_child = min(first_child + ARITY, size);
+			uint best = first_child;
+			for (uint child = first_child + 1; child < last_child; ++child) {
+				if (this->comp(this->items[child], this->items[best])) best = child;
+			}
+			if (!this->comp(this->items[best], item)) break;
+			this->Place(pos, this->items[best]);
+			pos = best;
 		}
-
-		if (store.next_position == block_size) NewBlock();
-
-		Ttype* next = static_cast<Ttype*>(store.current_block) + store.next_position;
-		store.next_position++;
-		return next;
+		this->Place(pos, item);
 	}
 
-	void deallocate(Ttype* p, size_t n)
+public:
+	/**
+	 * Create an empty heap.
+	 * @param size Number of nodes in the link graph.
+	 */
+	AnnoHeap(uint size) : positions(size, NOT_IN_HEAP)
 	{
-		store.last_freed = p;
+		this->items.reserve(size);
 	}
-};
-#endif
 
-/**
- * Annotation wrapper class which also stores an iterator to the AnnoSet node which points to this annotation
- * This is to enable erasing the AnnoSet node when calling Path::Fork without having to search the set
- */
-template<class Tannotation>
-struct AnnosWrapper : public Tannotation {
-#ifdef CUSTOM_ALLOCATOR
-	typename std::set<AnnoSetItem<Tannotation>, typename Tannotation::Comparator, AnnoSetAllocator<AnnoSetItem<Tannotation> > >::iterator self_iter;
-#else
-	typename std::set<AnnoSetItem<Tannotation>, typename Tannotation::Comparator>::iterator self_iter;
-#endif
+	/**
+	 * Check if the heap is empty.
+	 * @return If there are no items left.
+	 */
+	inline bool IsEmpty() const { return this->items.empty(); }
 
+	/**
+	 * Insert an annotation into the heap or, if it's already in there, move it
+	 * to the right place after its annotation value has changed.
+	 * @param anno Annotation to be inserted or updated.
+	 */
+	void InsertOrUpdate(Tannotation *anno)
+	{
+		Item item(anno);
+		uint pos = this->positions[item.node_id];
+		if (pos == NOT_IN_HEAP) {
+			pos = (uint)this->items.size();
+			this->items.push_back(item);
+			this->SiftUp(pos, item);
+		} else if (pos > 0 && this->comp(item, this->items[(pos - 1) / ARITY])) {
+			this->SiftUp(pos, item);
+		} else {
+			this->SiftDown(pos, item);
+		}
+	}
 
-	AnnosWrapper(NodeID n, bool source = false) : Tannotation(n, source) {}
+	/**
+	 * Remove the first annotation from the heap.
+	 * @return The annotation which was on top of the heap.
+	 */
+	Tannotation *Pop()
+	{
+		assert(!this->items.empty());
+		Tannotation *top = this->items.front().anno_ptr;
+		this->positions[this->items.front().node_id] = NOT_IN_HEAP;
+		Item last = this->items.back();
+		this->items.pop_back();
+		if (!this->items.empty()) this->SiftDown(0, last);
+		return top;
+	}
 };
 
 /**
@@ -363,40 +400,33 @@ struct AnnosWrapper : public Tannotation {
  * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
  * @param source_node Node where the algorithm starts.
  * @param paths Container for the paths to be calculated.
+ * @param allocator Allocator to allocate the paths from.
  */
 template<class Tannotation, class Tedge_iterator>
-void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
+void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths, DynUniformArenaAllocator &allocator)
 {
-#ifdef CUSTOM_ALLOCATOR
-	typedef std::set<AnnoSetItem<Tannotation>, typename Tannotation::Comparator, AnnoSetAllocator<AnnoSetItem<Tannotation> > > AnnoSet;
-	AnnoSetAllocatorStore annos_store;
-	AnnoSet annos = AnnoSet(typename Tannotation::Comparator(), AnnoSetAllocator<Tannotation *>(annos_store));
-#else
-	typedef std::set<AnnoSetItem<Tannotation>, typename Tannotation::Comparator> AnnoSet;
-	AnnoSet annos = AnnoSet(typename Tannotation::Comparator());
-#endif
 	Tedge_iterator iter(this->job);
 	uint size = this->job.Size();
+	AnnoHeap<Tannotation> annos(size);
 	paths.resize(size, NULL);
 
-	this->job.path_allocator.SetParameters(sizeof(AnnosWrapper<Tannotation>), (8192 - 32) / sizeof(AnnosWrapper<Tannotation>));
+	allocator.SetParameters(sizeof(Tannotation), (8192 - 32) / sizeof(Tannotation));
 
 	for (NodeID node = 0; node < size; ++node) {
-		AnnosWrapper<Tannotation> *anno = new (this->job.path_allocator.Allocate()) AnnosWrapper<Tannotation>(node, node == source_node);
+		Tannotation *anno = new (allocator.Allocate()) Tannotation(node, node == source_node);
 		anno->UpdateAnnotation();
-		anno->self_iter = annos.insert(AnnoSetItem<Tannotation>(anno)).first;
+		annos.InsertOrUpdate(anno);
 		paths[node] = anno;
 	}
-	while (!annos.empty()) {
-		typename AnnoSet::iterator i = annos.begin();
-		AnnosWrapper<Tannotation> *source = static_cast<AnnosWrapper<Tannotation> *>(i->anno_ptr);
-		annos.erase(i);
-		source->self_iter = annos.end();
+	while (!annos.IsEmpty()) {
+		Tannotation *source = annos.Pop();
 		NodeID from = source->GetNode();
 		iter.SetNode(source_node, from);
 		for (NodeID to = iter.Next(); to != INVALID_NODE; to = iter.Next()) {
 			if (to == from) continue; // Not a real edge but a consumption sign.
 			Edge edge = this->job[from][to];
+			/* Flows can still lead via stations the link to which has been removed. */
+			if (!edge.IsValid()) continue;
 			uint capacity = edge.Capacity();
 			if (this->max_saturation != UINT_MAX) {
 				capacity *= this->max_saturation;
@@ -405,23 +435,58 @@ void MultiCommodityFlow::Dijkstra(NodeID source_node, PathVector &paths)
 			}
 			/* punish in-between stops a little */
 			uint distance = DistanceMaxPlusManhattan(this->job[from].XY(), this->job[to].XY()) + 1;
-			AnnosWrapper<Tannotation> *dest = static_cast<AnnosWrapper<Tannotation> *>(paths[to]);
+			Tannotation *dest = static_cast<Tannotation *>(paths[to]);
 			if (dest->IsBetter(source, capacity, capacity - edge.Flow(), distance)) {
-				if (dest->self_iter != annos.end()) annos.erase(dest->self_iter);
 				dest->Fork(source, capacity, capacity - edge.Flow(), distance);
 				dest->UpdateAnnotation();
-				dest->self_iter = annos.insert(AnnoSetItem<Tannotation>(dest)).first;
+				annos.InsertOrUpdate(dest);
 			}
 		}
 	}
 }
 
+/**
+ * Run Dijkstra for a batch of consecutive source nodes. All runs see the
+ * state of the job from before the batch, so they can be done in parallel.
+ * Each run gets its own path container and path allocator.
+ * @tparam Tannotation Annotation to be used.
+ * @tparam Tedge_iterator Iterator to be used for getting outgoing edges.
+ * @param first First source node of the batch.
+ * @param count Number of source nodes in the batch.
+ * @param paths Array of count containers for the paths to be calculated.
+ */
+template<class Tannotation, class Tedge_iterator>
+void MultiCommodityFlow::DijkstraBatch(NodeID first, uint count, PathVector *paths)
+{
+	assert(count <= LinkGraphJob::PATH_ALLOCATOR_COUNT);
+	if (count == 1) {
+		this->Dijkstra<Tannotation, Tedge_iterator>(first, paths[0], this->job.path_allocators[0]);
+		return;
+	}
+	ThreadPool::ParallelFor(count, 1, [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			this->Dijkstra<Tannotation, Tedge_iterator>(first + i, paths[i], this->job.path_allocators[i]);
+		}
+	});
+}
+
+/**
+ * Get the number of source nodes to run Dijkstra for in one batch.
+ * Small link graphs are done one source at a time, as before.
+ * @return Batch size.
+ */
+uint MultiCommodityFlow::GetBatchSize() const
+{
+	return this->job.Size() >= MCF_BATCH_MIN_NODES ? LinkGraphJob::PATH_ALLOCATOR_COUNT : 1;
+}
+
 /**
  * Clean up paths that lead nowhere and the root path.
  * @param source_id ID of the root node.
  * @param paths Paths to be cleaned up.
+ * @param allocator Allocator the paths were allocated from.
  */
-void MultiCommodityFlow::CleanupPaths(NodeID source_id, PathVector &paths)
+void MultiCommodityFlow::CleanupPaths(NodeID source_id, PathVector &paths, DynUniformArenaAllocator &allocator)
 {
 	Path *source = paths[source_id];
 	paths[source_id] = NULL;
@@ -434,34 +499,57 @@ void MultiCommodityFlow::CleanupPaths(NodeID source_id, PathVector &paths)
 			path->Detach();
 			if (path->GetNumChildren() == 0) {
 				paths[path->GetNode()] = NULL;
-				this->job.path_allocator.Free(path);
+				allocator.Free(path);
 			}
 			path = parent;
 		}
 	}
-	this->job.path_allocator.Free(source);
+	allocator.Free(source);
 	paths.clear();
 }
 
 /**
  * Push flow along a path and update the unsatisfied_demand of the associated
- * edge.
- * @param edge Edge whose ends the path connects.
+ * pair of nodes.
+ * @param demand Demand between the nodes the path connects.
  * @param path End of the path the flow should be pushed on.
  * @param accuracy Accuracy of the calculation.
  * @param max_saturation If < UINT_MAX only push flow up to the given
  *                       saturation, otherwise the path can be "overloaded".
  */
-uint MultiCommodityFlow::PushFlow(Edge &edge, Path *path, uint accuracy,
+uint MultiCommodityFlow::PushFlow(DemandAnnotation &demand, Path *path, uint accuracy,
 		uint max_saturation)
 {
-	assert(edge.UnsatisfiedDemand() > 0);
-	uint flow = Clamp(edge.Demand() / accuracy, 1, edge.UnsatisfiedDemand());
+	assert(demand.UnsatisfiedDemand() > 0);
+	uint flow = Clamp(demand.Demand() / accuracy, 1, demand.UnsatisfiedDemand());
 	flow = path->AddFlow(flow, this->job, max_saturation);
-	edge.SatisfyDemand(flow);
+	demand.SatisfyDemand(flow);
 	return flow;
 }
 
+/**
+ * Get the free capacity of a path with the current flows, reduced by the
+ * max_saturation setting like Dijkstra does it.
+ * @param path End of the path.
+ * @return Smallest free capacity of all edges of the path.
+ */
+int MultiCommodityFlow::GetCurrentFreeCapacity(Path *path)
+{
+	int free_capacity = INT_MAX;
+	for (Path *parent = path->GetParent(); parent != NULL; path = parent, parent = path->GetParent()) {
+		Edge edge = this->job[parent->GetNode()][path->GetNode()];
+		if (!edge.IsValid()) return 0;
+		uint capacity = edge.Capacity();
+		if (this->max_saturation != UINT_MAX) {
+			capacity *= this->max_saturation;
+			capacity /= 100;
+			if (capacity == 0) capacity = 1;
+		}
+		free_capacity = min(free_capacity, (int)(capacity - edge.Flow()));
+	}
+	return free_capacity;
+}
+
 /**
  * Find the flow along a cycle including cycle_begin in path.
  * @param path Set of paths that form the cycle.
@@ -502,7 +590,7 @@ void MCF1stPass::EliminateCycle(PathVector &path, Path *cycle_begin, uint flow)
 		}
 		cycle_begin = path[prev];
 		Edge edge = this->job[prev][cycle_begin->GetNode()];
-		edge.RemoveFlow(flow);
+		if (edge.IsValid()) edge.RemoveFlow(flow);
 	} while (cycle_begin != cycle_end);
 }
 
@@ -613,37 +701,53 @@ bool MCF1stPass::EliminateCycles()
  */
 MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
-	PathVector paths;
+	PathVector batch_paths[LinkGraphJob::PATH_ALLOCATOR_COUNT];
 	uint size = job.Size();
 	uint accuracy = job.Settings().accuracy;
+	uint batch_size = this->GetBatchSize();
 	bool more_loops;
 
 	do {
 		more_loops = false;
-		for (NodeID source = 0; source < size; ++source) {
-			/* First saturate the shortest paths. */
-			this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(source, paths);
+		for (NodeID first = 0; first < size; first += batch_size) {
+			uint count = min(batch_size, size - first);
 
-			for (NodeID dest = 0; dest < size; ++dest) {
-				Edge edge = job[source][dest];
-				if (edge.UnsatisfiedDemand() > 0) {
-					Path *path = paths[dest];
+			/* First saturate the shortest paths. */
+			this->DijkstraBatch<DistanceAnnotation, GraphEdgeIterator>(first, count, batch_paths);
+
+			/* Push the flows in source order, so that the result doesn't depend on the scheduling. */
+			for (uint i = 0; i < count; ++i) {
+				NodeID source = first + i;
+				PathVector &paths = batch_paths[i];
+				/* The first source of a batch has seen all flow pushed so far, the others may not have. */
+				bool up_to_date = (i == 0);
+				DemandMap &demands = job[source].Demands();
+				for (DemandMap::iterator it = demands.begin(); it != demands.end(); ++it) {
+					DemandAnnotation &demand = it->second;
+					if (demand.UnsatisfiedDemand() == 0) continue;
+
+					Path *path = paths[it->first];
 					assert(path != NULL);
-					/* Generally only allow paths that don't exceed the
-					 * available capacity. But if no demand has been assigned
-					 * yet, make an exception and allow any valid path *once*. */
-					if (path->GetFreeCapacity() > 0 && this->PushFlow(edge, path,
+					if (!up_to_date && path->GetFreeCapacity() > 0 && this->GetCurrentFreeCapacity(path) <= 0) {
+						/* An earlier source of the batch has saturated the path. Search again with the
+						 * current flows, like a search for this source alone would have done. */
+						this->CleanupPaths(source, paths, job.path_allocators[i]);
+						this->Dijkstra<DistanceAnnotation, GraphEdgeIterator>(source, paths, job.path_allocators[i]);
+						up_to_date = true;
+						path = paths[it->first];
+					}
+
+					/* Only allow paths that don't exceed the available capacity. Demand
+					 * without such a path is left to the second pass. */
+					if (path->GetFreeCapacity() > 0 && this->PushFlow(demand, path,
 							accuracy, this->max_saturation) > 0) {
 						/* If a path has been found there is a chance we can
 						 * find more. */
-						more_loops = more_loops || (edge.UnsatisfiedDemand() > 0);
-					} else if (edge.UnsatisfiedDemand() == edge.Demand() &&
-							path->GetFreeCapacity() > INT_MIN) {
-						this->PushFlow(edge, path, accuracy, UINT_MAX);
+						more_loops = more_loops || (demand.UnsatisfiedDemand() > 0);
 					}
 				}
+				this->CleanupPaths(source, paths, job.path_allocators[i]);
 			}
-			this->CleanupPaths(source, paths);
 		}
 	} while ((more_loops || this->EliminateCycles()) && !job.IsJobAborted());
 }
@@ -656,32 +760,39 @@ MCF1stPass::MCF1stPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 MCF2ndPass::MCF2ndPass(LinkGraphJob &job) : MultiCommodityFlow(job)
 {
 	this->max_saturation = UINT_MAX; // disable artificial cap on saturation
-	PathVector paths;
+	PathVector batch_paths[LinkGraphJob::PATH_ALLOCATOR_COUNT];
 	uint size = job.Size();
 	uint accuracy = job.Settings().accuracy;
+	uint batch_size = this->GetBatchSize();
 	bool demand_left = true;
 	while (demand_left && !job.IsJobAborted()) {
 		demand_left = false;
-		for (NodeID source = 0; source < size; ++source) {
-			this->Dijkstra<CapacityAnnotation, FlowEdgeIterator>(source, paths);
-			for (NodeID dest = 0; dest < size; ++dest) {
-				Edge edge = this->job[source][dest];
-				Path *path = paths[dest];
-				if (edge.UnsatisfiedDemand() > 0 && path->GetFreeCapacity() > INT_MIN) {
-					this->PushFlow(edge, path, accuracy, UINT_MAX);
-					if (edge.UnsatisfiedDemand() > 0) demand_left = true;
+		for (NodeID first = 0; first < size; first += batch_size) {
+			uint count = min(batch_size, size - first);
+			this->DijkstraBatch<CapacityAnnotation, FlowEdgeIterator>(first, count, batch_paths);
+			for (uint i = 0; i < count; ++i) {
+				NodeID source = first + i;
+				PathVector &paths = batch_paths[i];
+				DemandMap &demands = this->job[source].Demands();
+				for (DemandMap::iterator it = demands.begin(); it != demands.end(); ++it) {
+					DemandAnnotation &demand = it->second;
+					Path *path = paths[it->first];
+					if (demand.UnsatisfiedDemand() > 0 && path->GetFreeCapacity() > INT_MIN) {
+						this->PushFlow(demand, path, accuracy, UINT_MAX);
+						if (demand.UnsatisfiedDemand() > 0) demand_left = true;
+					}
 				}
+				this->CleanupPaths(source, paths, this->job.path_allocators[i]);
 			}
-			this->CleanupPaths(source, paths);
 		}
 	}
 }
 
 /**
  * Relation that creates a weak order without duplicates.
- * Avoid accidentally deleting different paths of the same capacity/distance in
- * a set. When the annotation is the same node IDs are compared, so there are
- * no equal ranges.
+ * This makes the order in which Dijkstra visits paths of the same
+ * capacity/distance well defined. When the annotation is the same node IDs
+ * are compared, so there are no equal ranges.
  * @tparam T Type to be compared on.
  * @param x_anno First value.
  * @param y_anno Second value.
@@ -702,8 +813,8 @@ bool Greater(T x_anno, T y_anno, NodeID x, NodeID y)
  * @param y Second capacity annotation.
  * @return If x is better than y.
  */
-bool CapacityAnnotation::Comparator::operator()(const AnnoSetItem<CapacityAnnotation> &x,
-		const AnnoSetItem<CapacityAnnotation> &y) const
+bool CapacityAnnotation::Comparator::operator()(const AnnoHeapItem<CapacityAnnotation> &x,
+		const AnnoHeapItem<CapacityAnnotation> &y) const
 {
 	return x.anno_ptr != y.anno_ptr && Greater<int>(x.cached_annotation, y.cached_annotation,
 			x.node_id, y.node_id);
@@ -715,8 +826,8 @@ bool CapacityAnnotation::Comparator::operator()(const AnnoSetItem<CapacityAnnota
  * @param y Second distance annotation.
  * @return If x is better than y.
  */
-bool DistanceAnnotation::Comparator::operator()(const AnnoSetItem<DistanceAnnotation> &x,
-		const AnnoSetItem<DistanceAnnotation> &y) const
+bool DistanceAnnotation::Comparator::operator()(const AnnoHeapItem<DistanceAnnotation> &x,
+		const AnnoHeapItem<DistanceAnnotation> &y) const
 {
 	return x.anno_ptr != y.anno_ptr && !Greater<uint>(x.cached_annotation, y.cached_annotation,
 			x.node_id, y.node_id);
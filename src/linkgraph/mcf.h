@@ -22,11 +22,18 @@ protected:
 	{}
 
 	template<class Tannotation, class Tedge_iterator>
-	void Dijkstra(NodeID from, PathVector &paths);
+	void Dijkstra(NodeID from, PathVector &paths, DynUniformArenaAllocator &allocator);
 
-	uint PushFlow(Edge &edge, Path *path, uint accuracy, uint max_saturation);
+	template<class Tannotation, class Tedge_iterator>
+	void DijkstraBatch(NodeID first, uint count, PathVector *paths);
+
+	uint GetBatchSize() const;
+
+	uint PushFlow(DemandAnnotation &demand, Path *path, uint accuracy, uint max_saturation);
+
+	int GetCurrentFreeCapacity(Path *path);
 
-	void CleanupPaths(NodeID source, PathVector &paths);
+	void CleanupPaths(NodeID source, PathVector &paths, DynUniformArenaAllocator &allocator);
 
 	LinkGraphJob &job;   ///< Job we're working with.
 	uint max_saturation; ///< Maximum saturation for edges.
@@ -14,6 +14,10 @@
 #include "core/alloc_func.hpp"
 #include "water_map.h"
 #include "string_func.h"
+#include "pathfinder/water_regions.h"
+#include "station_func.h"
+#include "viewport_func.h"
+#include "vehicle_func.h"
 
 #include "safeguards.h"
 
@@ -29,8 +33,9 @@ uint _map_size_y;    ///< Size of the map along the Y
 uint _map_size;      ///< The number of tiles on the map
 uint _map_tile_mask; ///< _map_size - 1 (to mask the mapsize)
 
-Tile *_m = NULL;          ///< Tiles of the map
-TileExtended *_me = NULL; ///< Extended Tiles of the map
+TileTypeHeight *_mth = NULL; ///< Type and height of the tiles of the map
+Tile *_m = NULL;             ///< Tiles of the map
+TileExtended *_me = NULL;    ///< Extended Tiles of the map
 
 /**
  * Validates whether a map with the given dimension is valid
@@ -73,11 +78,19 @@ void AllocateMap(uint size_x, uint size_y)
 	_map_size = size_x * size_y;
 	_map_tile_mask = _map_size - 1;
 
+	free(_mth);
 	free(_m);
 	free(_me);
 
+	_mth = CallocT<TileTypeHeight>(_map_size);
 	_m = CallocT<Tile>(_map_size);
 	_me = CallocT<TileExtended>(_map_size);
+
+	AllocateWaterRegions();
+	AllocateVehicleTileHash();
+	AllocateStationCatchmentIndex();
+	AllocateViewportMapTileColourCache();
+	ClearViewportTileSpriteCache();
 }
 
 
@@ -27,6 +27,14 @@ extern uint _map_tile_mask;
 
 #define TILE_MASK(x) ((x) & _map_tile_mask)
 
+/**
+ * Pointer to the tile type and height array.
+ *
+ * This variable points to the array which contains the type and height
+ * of the tiles of the map.
+ */
+extern TileTypeHeight *_mth;
+
 /**
  * Pointer to the tile-array.
  *
@@ -13,12 +13,22 @@
 #define MAP_TYPE_H
 
 /**
- * Data that is stored per tile. Also used TileExtended for this.
+ * Type and height of a tile. These are by far the most frequently accessed
+ * data of a tile, so they are kept in their own dense array, apart from Tile and TileExtended.
  * Look at docs/landscape.html for the exact meaning of the members.
  */
-struct Tile {
+struct TileTypeHeight {
 	byte   type;        ///< The type (bits 4..7), bridges (2..3), rainforest/desert (0..1)
 	byte   height;      ///< The height of the northern corner.
+};
+
+assert_compile(sizeof(TileTypeHeight) == 2);
+
+/**
+ * Data that is stored per tile. Also used TileTypeHeight and TileExtended for this.
+ * Look at docs/landscape.html for the exact meaning of the members.
+ */
+struct Tile {
 	uint16 m2;          ///< Primarily used for indices to towns, industries and stations
 	byte   m1;          ///< Primarily used for ownership information
 	byte   m3;          ///< General purpose
@@ -26,10 +36,10 @@ struct Tile {
 	byte   m5;          ///< General purpose
 };
 
-assert_compile(sizeof(Tile) == 8);
+assert_compile(sizeof(Tile) == 6);
 
 /**
- * Data that is stored per tile. Also used Tile for this.
+ * Data that is stored per tile. Also used TileTypeHeight and Tile for this.
  * Look at docs/landscape.html for the exact meaning of the members.
  */
 struct TileExtended {
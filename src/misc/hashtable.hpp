@@ -187,6 +187,7 @@ public:
 	inline void Clear()
 	{
 		for (int i = 0; i < Tcapacity; i++) m_slots[i].Clear();
+		m_num_items = 0;
 	}
 
 	/** const item search */
@@ -184,6 +184,18 @@ static inline void OTTDfreeaddrinfo(struct addrinfo *ai)
 #	include <errno.h>
 #	include <sys/time.h>
 #	include <netdb.h>
+
+/* Linux has epoll, which scales better than select with many sockets. */
+#	if defined(__linux__)
+#		include <sys/epoll.h>
+#		define HAVE_EPOLL
+#	endif
+
+/* With writev several queued packets can be sent in one system call. */
+#	if !defined(__MORPHOS__) && !defined(__AMIGA__) && !defined(BEOS_NET_SERVER)
+#		include <sys/uio.h>
+#		define HAVE_WRITEV
+#	endif
 #endif /* UNIX */
 
 #ifdef __BEOS__
@@ -16,11 +16,115 @@
 #include "../../stdafx.h"
 #include "../../string_func.h"
 #include "../../command_type.h"
+#include "../../thread/thread.h"
 
 #include "packet.h"
 
+#include <vector>
+
 #include "../../safeguards.h"
 
+/**
+ * Cache of freed packets and packet buffers, so the frequent small packets do not
+ * need two heap allocations, one of them SHRT_MAX bytes large, each time.
+ * Packets are made and freed by the save thread as well, so it is protected by a mutex.
+ */
+struct PacketCache {
+	static const size_t MAX_ITEMS = 64; ///< Maximum number of cached packets and of cached buffers.
+
+	ThreadMutex *mutex;          ///< Mutex protecting the cache.
+	std::vector<void *> packets; ///< Memory of freed Packets.
+	std::vector<byte *> buffers; ///< Freed packet buffers.
+
+	PacketCache() : mutex(ThreadMutex::New()) {}
+
+	/**
+	 * Get the cache. It is created on first use, and deliberately never freed,
+	 * so packets can still be freed while static objects are destroyed.
+	 * @return The cache.
+	 */
+	static PacketCache &Get()
+	{
+		static PacketCache *cache = new PacketCache();
+		return *cache;
+	}
+};
+
+/**
+ * Get a buffer for a packet, reusing a freed one when possible.
+ * @return The buffer of SHRT_MAX bytes.
+ */
+static byte *AllocatePacketBuffer()
+{
+	PacketCache &cache = PacketCache::Get();
+	{
+		ThreadMutexLocker lock(cache.mutex);
+		if (!cache.buffers.empty()) {
+			byte *buffer = cache.buffers.back();
+			cache.buffers.pop_back();
+			return buffer;
+		}
+	}
+	return MallocT<byte>(SHRT_MAX);
+}
+
+/**
+ * Free the buffer of a packet, or keep it for reuse.
+ * @param buffer The buffer.
+ */
+static void FreePacketBuffer(byte *buffer)
+{
+	PacketCache &cache = PacketCache::Get();
+	{
+		ThreadMutexLocker lock(cache.mutex);
+		if (cache.buffers.size() < PacketCache::MAX_ITEMS) {
+			cache.buffers.push_back(buffer);
+			return;
+		}
+	}
+	free(buffer);
+}
+
+/**
+ * Allocate the memory for a packet, reusing the memory of a freed one when possible.
+ * @param size Size of the packet.
+ * @return The memory.
+ */
+/* static */ void *Packet::operator new(size_t size)
+{
+	assert(size == sizeof(Packet));
+
+	PacketCache &cache = PacketCache::Get();
+	{
+		ThreadMutexLocker lock(cache.mutex);
+		if (!cache.packets.empty()) {
+			void *p = cache.packets.back();
+			cache.packets.pop_back();
+			return p;
+		}
+	}
+	return MallocT<byte>(size);
+}
+
+/**
+ * Free the memory of a packet, or keep it for reuse.
+ * @param p The memory.
+ */
+/* static */ void Packet::operator delete(void *p)
+{
+	if (p == NULL) return;
+
+	PacketCache &cache = PacketCache::Get();
+	{
+		ThreadMutexLocker lock(cache.mutex);
+		if (cache.packets.size() < PacketCache::MAX_ITEMS) {
+			cache.packets.push_back(p);
+			return;
+		}
+	}
+	free(p);
+}
+
 /**
  * Create a packet that is used to read from a network socket
  * @param cs the socket handler associated with the socket we are reading from
@@ -33,7 +137,7 @@ Packet::Packet(NetworkSocketHandler *cs)
 	this->next   = NULL;
 	this->pos    = 0; // We start reading from here
 	this->size   = 0;
-	this->buffer = MallocT<byte>(SHRT_MAX);
+	this->buffer = AllocatePacketBuffer();
 }
 
 /**
@@ -48,7 +152,7 @@ Packet::Packet(PacketType type)
 	/* Skip the size so we can write that in before sending the packet */
 	this->pos                  = 0;
 	this->size                 = sizeof(PacketSize);
-	this->buffer               = MallocT<byte>(SHRT_MAX);
+	this->buffer               = AllocatePacketBuffer();
 	this->buffer[this->size++] = type;
 }
 
@@ -57,7 +161,7 @@ Packet::Packet(PacketType type)
  */
 Packet::~Packet()
 {
-	free(this->buffer);
+	FreePacketBuffer(this->buffer);
 }
 
 /**
@@ -64,6 +64,9 @@ public:
 	Packet(PacketType type);
 	~Packet();
 
+	static void *operator new(size_t size);
+	static void operator delete(void *p);
+
 	/* Sending/writing of packets */
 	void PrepareToSend();
 
@@ -107,7 +107,20 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 
 	p = this->packet_queue;
 	while (p != NULL) {
+#ifdef HAVE_WRITEV
+		/* Send as many of the queued packets as possible in one go. */
+		struct iovec iov[64];
+		int count = 0;
+		size_t total = 0;
+		for (Packet *q = p; q != NULL && count < (int)lengthof(iov); q = q->next, count++) {
+			iov[count].iov_base = q->buffer + q->pos;
+			iov[count].iov_len = q->size - q->pos;
+			total += q->size - q->pos;
+		}
+		res = writev(this->sock, iov, count);
+#else
 		res = send(this->sock, (const char*)p->buffer + p->pos, p->size - p->pos, 0);
+#endif /* HAVE_WRITEV */
 		if (res == -1) {
 			int err = GET_LAST_ERROR();
 			if (err != EWOULDBLOCK) {
@@ -118,6 +131,8 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 				}
 				return SPS_CLOSED;
 			}
+			/* Wait until the socket is reported writable again. */
+			this->writable = false;
 			return SPS_PARTLY_SENT;
 		}
 		if (res == 0) {
@@ -126,6 +141,23 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 			return SPS_CLOSED;
 		}
 
+#ifdef HAVE_WRITEV
+		/* Remove the packets that have been sent completely. */
+		for (size_t sent = res; sent > 0;) {
+			size_t left = p->size - p->pos;
+			if (sent < left) {
+				p->pos += (PacketSize)sent;
+				break;
+			}
+			sent -= left;
+			this->packet_queue = p->next;
+			delete p;
+			p = this->packet_queue;
+		}
+
+		/* Not everything could be sent, so the socket's buffer is full. */
+		if ((size_t)res < total) return SPS_PARTLY_SENT;
+#else
 		p->pos += res;
 
 		/* Is this packet sent? */
@@ -137,6 +169,7 @@ SendPacketsState NetworkTCPSocketHandler::SendPackets(bool closing_down)
 		} else {
 			return SPS_PARTLY_SENT;
 		}
+#endif /* HAVE_WRITEV */
 	}
 
 	return SPS_ALL_SENT;
@@ -63,6 +63,7 @@ enum PacketAdminType {
 	ADMIN_PACKET_SERVER_GAMESCRIPT,      ///< The server gives the admin information from the GameScript in JSON.
 	ADMIN_PACKET_SERVER_RCON_END,        ///< The server indicates that the remote console command has completed.
 	ADMIN_PACKET_SERVER_PONG,            ///< The server replies to a ping request from the admin.
+	ADMIN_PACKET_SERVER_TICK_TIMINGS,    ///< The server gives the admin the time spent in a part of the game tick.
 
 	INVALID_ADMIN_PACKET = 0xFF,         ///< An invalid marker for admin packets.
 };
@@ -86,6 +87,7 @@ enum AdminUpdateType {
 	ADMIN_UPDATE_CMD_NAMES,       ///< The admin would like a list of all DoCommand names.
 	ADMIN_UPDATE_CMD_LOGGING,     ///< The admin would like to have DoCommand information.
 	ADMIN_UPDATE_GAMESCRIPT,      ///< The admin would like to have gamescript messages.
+	ADMIN_UPDATE_TICK_TIMINGS,    ///< The admin would like to have the time spent in the parts of the game tick.
 	ADMIN_UPDATE_END,             ///< Must ALWAYS be on the end of this list!! (period)
 };
 
@@ -481,6 +483,23 @@ protected:
 	 */
 	virtual NetworkRecvStatus Receive_SERVER_RCON_END(Packet *p);
 
+	/**
+	 * The time spent per tick in a part of the game tick, over the last ticks:
+	 * uint8   ID of the part of the game tick.
+	 * string  Name of the part of the game tick.
+	 * uint16  Number of ticks the statistics are about.
+	 * uint32  Average time per tick, in nanoseconds.
+	 * uint32  Median time per tick, in nanoseconds.
+	 * uint32  99th percentile of the time per tick, in nanoseconds.
+	 * uint32  Maximum time per tick, in nanoseconds.
+	 * uint8   Number of histogram buckets that follow.
+	 * uint16  For each bucket n, the number of ticks that took less than 2^n microseconds
+	 *         (and not less than 2^(n-1)); the last bucket counts all longer ticks.
+	 * @param p The packet that was just received.
+	 * @return The state the network should have.
+	 */
+	virtual NetworkRecvStatus Receive_SERVER_TICK_TIMINGS(Packet *p);
+
 	NetworkRecvStatus HandlePacket(Packet *p);
 public:
 	NetworkRecvStatus CloseConnection(bool error = true);
@@ -14,7 +14,7 @@
 #ifdef ENABLE_NETWORK
 
 #include "../../stdafx.h"
-#include "../../thread/thread.h"
+#include "../../thread/thread_pool.h"
 
 #include "tcp.h"
 
@@ -35,7 +35,7 @@ TCPConnecter::TCPConnecter(const NetworkAddress &address) :
 	address(address)
 {
 	*_tcp_connecters.Append() = this;
-	if (!ThreadObject::New(TCPConnecter::ThreadEntry, this, &this->thread, "ottd:tcp")) {
+	if (!ThreadPool::Submit(TCPConnecter::ThreadEntry, this, NULL, TPTF_BLOCKING, "ottd:tcp")) {
 		this->Connect();
 	}
 }
@@ -52,7 +52,7 @@ void TCPConnecter::Connect()
 }
 
 /**
- * Entry point for the new threads.
+ * Entry point for the thread pool task.
  * @param param the TCPConnecter instance to call Connect on.
  */
 /* static */ void TCPConnecter::ThreadEntry(void *param)
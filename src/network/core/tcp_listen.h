@@ -33,6 +33,104 @@ class TCPListenHandler {
 	/** List of sockets we listen on. */
 	static SocketList sockets;
 
+#ifdef HAVE_EPOLL
+	/** The epoll instance all our sockets are registered with, or -1 when select is used. */
+	static int epoll_fd;
+
+	/** Sockets that may still have data to read, in the same encoding as the epoll event data. */
+	static SmallVector<uint64, 16> epoll_pending;
+
+	/** Value of the index half of the epoll event data for listening sockets. */
+	static const uint32 EPOLL_LISTENER = UINT32_MAX;
+
+	/**
+	 * Register a socket with the epoll instance.
+	 * Sockets stay registered until they are closed, and are edge-triggered:
+	 * an event means the readiness changed, so readable sockets have to be read until they would block (see #EpollReceive).
+	 * @param s The socket.
+	 * @param index Index of the socket handler in the pool, or #EPOLL_LISTENER.
+	 */
+	static void EpollRegister(SOCKET s, uint32 index)
+	{
+		struct epoll_event ev;
+		ev.events = EPOLLIN | EPOLLOUT | EPOLLET;
+		ev.data.u64 = ((uint64)index << 32) | (uint32)s;
+		if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, s, &ev) < 0) {
+			DEBUG(net, 0, "[%s] epoll_ctl failed with error %d", Tsocket::GetName(), GET_LAST_ERROR());
+		}
+	}
+
+	/**
+	 * Read the packets of a socket that was reported readable.
+	 * The handler may stop reading before the socket would block, e.g. when a client
+	 * runs out of its receive limit. As no new edge is reported for the data that is
+	 * left in the kernel, such sockets are kept in #epoll_pending and retried every frame.
+	 * @param data The epoll event data of the socket.
+	 */
+	static void EpollReceive(uint64 data)
+	{
+		uint32 index = (uint32)(data >> 32);
+		SOCKET s = (SOCKET)(uint32)data;
+
+		/* The handler may have been deleted, or its pool slot reused, since the event was queued. */
+		if (!Tsocket::IsValidID(index)) return;
+		Tsocket *cs = Tsocket::Get(index);
+		if (cs->sock != s) return;
+
+		/* Any other status means the connection is closed, and the handler might be gone. */
+		if (cs->ReceivePackets() != NETWORK_RECV_STATUS_OKAY) return;
+
+		char c;
+		if (recv(s, &c, 1, MSG_PEEK) == -1 && GET_LAST_ERROR() == EWOULDBLOCK) return;
+		epoll_pending.Include(data);
+	}
+
+	/**
+	 * Handle the receiving of packets, using epoll.
+	 * Only the sockets with changed readiness, or with unread data, are looked at,
+	 * so the cost does not depend on the number of idle connections.
+	 * @return true if everything went okay.
+	 */
+	static bool ReceiveEpoll()
+	{
+		if (epoll_pending.Length() != 0) {
+			SmallVector<uint64, 16> pending;
+			for (const uint64 *data = epoll_pending.Begin(); data != epoll_pending.End(); data++) {
+				*pending.Append() = *data;
+			}
+			epoll_pending.Clear();
+			for (const uint64 *data = pending.Begin(); data != pending.End(); data++) {
+				EpollReceive(*data);
+			}
+		}
+
+		struct epoll_event events[64];
+		for (;;) {
+			int count = epoll_wait(epoll_fd, events, lengthof(events), 0); // don't block at all.
+			if (count < 0) return GET_LAST_ERROR() == EINTR && _networking;
+
+			for (int i = 0; i < count; i++) {
+				uint32 index = (uint32)(events[i].data.u64 >> 32);
+				SOCKET s = (SOCKET)(uint32)events[i].data.u64;
+
+				if (index == EPOLL_LISTENER) {
+					AcceptClient(s);
+					continue;
+				}
+
+				if (events[i].events & EPOLLOUT) {
+					/* The handler may have been deleted, or its pool slot reused, since the event was queued. */
+					if (Tsocket::IsValidID(index) && Tsocket::Get(index)->sock == s) Tsocket::Get(index)->writable = true;
+				}
+				if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) EpollReceive(events[i].data.u64);
+			}
+
+			if (count < (int)lengthof(events)) break;
+		}
+		return _networking;
+	}
+#endif /* HAVE_EPOLL */
+
 public:
 	/**
 	 * Accepts clients from the sockets.
@@ -90,6 +188,18 @@ public:
 			}
 
 			Tsocket::AcceptConnection(s, address);
+
+#ifdef HAVE_EPOLL
+			if (epoll_fd != -1) {
+				Tsocket *cs;
+				FOR_ALL_ITEMS_FROM(Tsocket, idx, cs, 0) {
+					if (cs->sock == s) {
+						EpollRegister(s, cs->index);
+						break;
+					}
+				}
+			}
+#endif /* HAVE_EPOLL */
 		}
 	}
 
@@ -99,6 +209,10 @@ public:
 	 */
 	static bool Receive()
 	{
+#ifdef HAVE_EPOLL
+		if (epoll_fd != -1) return ReceiveEpoll();
+#endif /* HAVE_EPOLL */
+
 		fd_set read_fd, write_fd;
 		struct timeval tv;
 
@@ -161,6 +275,19 @@ public:
 			return false;
 		}
 
+#ifdef HAVE_EPOLL
+		/* Without epoll we silently fall back to select. */
+		assert(epoll_fd == -1);
+		epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+		if (epoll_fd != -1) {
+			for (SocketList::iterator s = sockets.Begin(); s != sockets.End(); s++) {
+				EpollRegister(s->second, EPOLL_LISTENER);
+			}
+		} else {
+			DEBUG(net, 1, "[%s] epoll_create1 failed with error %d, using select", Tsocket::GetName(), GET_LAST_ERROR());
+		}
+#endif /* HAVE_EPOLL */
+
 		return true;
 	}
 
@@ -171,11 +298,22 @@ public:
 			closesocket(s->second);
 		}
 		sockets.Clear();
+#ifdef HAVE_EPOLL
+		if (epoll_fd != -1) {
+			close(epoll_fd);
+			epoll_fd = -1;
+		}
+		epoll_pending.Reset();
+#endif /* HAVE_EPOLL */
 		DEBUG(net, 1, "[%s] closed listeners", Tsocket::GetName());
 	}
 };
 
 template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> SocketList TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::sockets;
+#ifdef HAVE_EPOLL
+template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> int TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::epoll_fd = -1;
+template <class Tsocket, PacketType Tfull_packet, PacketType Tban_packet> SmallVector<uint64, 16> TCPListenHandler<Tsocket, Tfull_packet, Tban_packet>::epoll_pending;
+#endif /* HAVE_EPOLL */
 
 #endif /* ENABLE_NETWORK */
 
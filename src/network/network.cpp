@@ -37,15 +37,13 @@
 #include "../core/pool_func.hpp"
 #include "../gfx_func.h"
 #include "../error.h"
+#include "../fileio_func.h"
+#include "../map_func.h"
+#include "../openttd.h"
+#include "../tick_timing.h"
 
 #include "../safeguards.h"
 
-#ifdef DEBUG_DUMP_COMMANDS
-#include "../fileio_func.h"
-/** When running the server till the wait point, run as fast as we can! */
-bool _ddc_fastforward = true;
-#endif /* DEBUG_DUMP_COMMANDS */
-
 /** Make sure both pools have the same size. */
 assert_compile(NetworkClientInfoPool::MAX_SIZE == NetworkClientSocketPool::MAX_SIZE);
 
@@ -82,6 +80,10 @@ bool _network_udp_server;             ///< Is the UDP server started?
 uint16 _network_udp_broadcast;        ///< Timeout for the UDP broadcasts.
 uint8 _network_advertise_retries;     ///< The number of advertisement retries we did.
 CompanyMask _network_company_passworded; ///< Bitmask of the password status of all companies.
+bool _network_replaying;              ///< Are we replaying a command log?
+char *_network_replay_file;           ///< The command log to replay.
+uint32 _network_replay_ticks;         ///< Number of ticks to run when replaying, 0 to run until the end of the command log.
+bool _ddc_fastforward;                ///< When running the server till the wait point, run as fast as we can!
 
 /* Check whether NETWORK_NUM_LANDSCAPES is still in sync with NUM_LANDSCAPE */
 assert_compile((int)NETWORK_NUM_LANDSCAPES == (int)NUM_LANDSCAPE);
@@ -881,6 +883,149 @@ void NetworkBackgroundLoop()
 	NetworkBackgroundUDPLoop();
 }
 
+/** Number of ticks that have been run since the replay started. */
+static uint32 _network_replay_tick_count;
+/** Clock value at the start of the replay. */
+static uint64 _network_replay_start;
+
+/**
+ * Print the results of replaying the command log: the time spent in
+ * the parts of the game tick and a checksum of the game state.
+ */
+static void NetworkReplayReport()
+{
+	uint64 elapsed = GetTickTimingClock() - _network_replay_start;
+	uint32 ticks = max<uint32>(_network_replay_tick_count, 1);
+	DEBUG(net, 0, "replay: %u ticks in %.3f s, %.3f ms per tick", _network_replay_tick_count, elapsed / 1e9, elapsed / 1e6 / ticks);
+	for (int i = 0; i < TTP_END; i++) {
+		const TickTimingTotal &total = GetTickTimingTotal((TickTimingPhase)i);
+		DEBUG(net, 0, "replay: %-16s %10.3f ms total, %8.3f ms per tick", GetTickTimingName((TickTimingPhase)i), total.time / 1e6, total.time / 1e6 / ticks);
+	}
+
+	Md5 checksum;
+	checksum.Append(_mth, MapSize() * sizeof(*_mth));
+	checksum.Append(_m, MapSize() * sizeof(*_m));
+	checksum.Append(_me, MapSize() * sizeof(*_me));
+	checksum.Append(_random.state, sizeof(_random.state));
+	uint8 digest[16];
+	checksum.Finish(digest);
+	char hex[33];
+	md5sumToString(hex, lastof(hex), digest);
+	DEBUG(net, 0, "replay: date{%08x; %02x; %02x}; %08x; %08x; state checksum %s", _date, _date_fract, _tick_skip_counter, _random.state[0], _random.state[1], hex);
+}
+
+/**
+ * Replay the command log given on the command line: inject the logged
+ * commands at their logged dates and check the logged sync states.
+ * See docs/desync.txt for details.
+ */
+static void NetworkReplayCommandLog()
+{
+	static FILE *f = NULL;
+	static Date next_date = 0;
+	static uint32 next_date_fract;
+	static uint next_tick_skip_counter;
+	static CommandPacket *cp = NULL;
+	static bool check_sync_state = false;
+	static uint32 sync_state[2];
+
+	if (_network_replay_start == 0) {
+		f = FioFOpenFile(_network_replay_file, "rb", SAVE_DIR);
+		if (f == NULL) usererror("Cannot open command log '%s'", _network_replay_file);
+		ResetTickTimings();
+		_network_replay_start = GetTickTimingClock();
+		_ddc_fastforward = true;
+	}
+
+	while (f != NULL && !feof(f)) {
+		if (_date == next_date && _date_fract == next_date_fract && _tick_skip_counter == next_tick_skip_counter) {
+			if (cp != NULL) {
+				NetworkSendCommand(cp->tile, cp->p1, cp->p2, cp->cmd & ~CMD_FLAGS_MASK, NULL, cp->text, cp->company, cp->binary_length);
+				DEBUG(net, 0, "injecting: date{%08x; %02x; %02x}; %02x; %06x; %08x; %08x; %08x; \"%s\" (%s)", _date, _date_fract, _tick_skip_counter, (int)_current_company, cp->tile, cp->p1, cp->p2, cp->cmd, cp->text, GetCommandName(cp->cmd));
+				free(cp);
+				cp = NULL;
+			}
+			if (check_sync_state) {
+				if (sync_state[0] == _random.state[0] && sync_state[1] == _random.state[1]) {
+					DEBUG(net, 0, "sync check: date{%08x; %02x; %02x}; match", _date, _date_fract, _tick_skip_counter);
+				} else {
+					error("Replay desynced at date{%08x; %02x; %02x}: expected {%08x, %08x}, got {%08x, %08x}",
+							_date, _date_fract, _tick_skip_counter, sync_state[0], sync_state[1], _random.state[0], _random.state[1]);
+				}
+				check_sync_state = false;
+			}
+		}
+
+		if (cp != NULL || check_sync_state) break;
+
+		char buff[4096];
+		if (fgets(buff, lengthof(buff), f) == NULL) break;
+
+		char *p = buff;
+		/* Ignore the "[date time] " part of the message */
+		if (*p == '[') {
+			p = strchr(p, ']');
+			if (p == NULL) break;
+			p += 2;
+		}
+
+		if (strncmp(p, "cmd: ", 5) == 0
+#ifdef DEBUG_FAILED_DUMP_COMMANDS
+			|| strncmp(p, "cmdf: ", 6) == 0
+#endif
+			) {
+			p += 5;
+			if (*p == ' ') p++;
+			cp = CallocT<CommandPacket>(1);
+			int company;
+			int ret = sscanf(p, "date{%x; %x; %x}; %x; %x; %x; %x; %x; \"%[^\"]\"", &next_date, &next_date_fract, &next_tick_skip_counter, &company, &cp->tile, &cp->p1, &cp->p2, &cp->cmd, cp->text);
+			/* There are 9 pieces of data to read, however the last is a
+			 * string that might or might not exist. Ignore it if that
+			 * string misses because in 99% of the time it's not used. */
+			if (ret != 9 && ret != 8) usererror("Invalid command in command log: %s", p);
+			cp->company = (CompanyID)company;
+		} else if (strncmp(p, "join: ", 6) == 0 && _network_replay_ticks == 0) {
+			/* Manually insert a pause when joining; this way the client can join at the exact right time. */
+			int ret = sscanf(p + 6, "date{%x; %x; %x}", &next_date, &next_date_fract, &next_tick_skip_counter);
+			if (ret != 3) usererror("Invalid join in command log: %s", p);
+			DEBUG(net, 0, "injecting pause for join at date{%08x; %02x; %02x}; please join when paused", next_date, next_date_fract, next_tick_skip_counter);
+			cp = CallocT<CommandPacket>(1);
+			cp->company = COMPANY_SPECTATOR;
+			cp->cmd = CMD_PAUSE;
+			cp->p1 = PM_PAUSED_NORMAL;
+			cp->p2 = 1;
+			_ddc_fastforward = false;
+		} else if (strncmp(p, "sync: ", 6) == 0) {
+			int ret = sscanf(p + 6, "date{%x; %x; %x}; %x; %x", &next_date, &next_date_fract, &next_tick_skip_counter, &sync_state[0], &sync_state[1]);
+			if (ret != 5) usererror("Invalid sync state in command log: %s", p);
+			check_sync_state = true;
+		} else if (strncmp(p, "msg: ", 5) == 0 || strncmp(p, "client: ", 8) == 0 ||
+					strncmp(p, "load: ", 6) == 0 || strncmp(p, "save: ", 6) == 0 ||
+					strncmp(p, "join: ", 6) == 0) {
+			/* A message that is not very important to the log playback, but part of the log.
+			 * Joins only pause the game when not running a fixed number of ticks. */
+#ifndef DEBUG_FAILED_DUMP_COMMANDS
+		} else if (strncmp(p, "cmdf: ", 6) == 0) {
+			DEBUG(net, 0, "Skipping replay of failed command: %s", p + 6);
+#endif
+		} else {
+			/* Can't parse a line; what's wrong here? */
+			usererror("Cannot parse line in command log: %s", p);
+		}
+	}
+	if (f != NULL && feof(f)) {
+		DEBUG(net, 0, "End of command log");
+		fclose(f);
+		f = NULL;
+
+		/* Unless waiting for a client to join, we are done when running till the end of the log. */
+		if (_network_replay_ticks == 0 && _ddc_fastforward) {
+			NetworkReplayReport();
+			_exit_game = true;
+		}
+	}
+}
+
 /* The main loop called from ttd.c
  *  Here we also have to do StateGameLoop if needed! */
 void NetworkGameLoop()
@@ -900,102 +1045,8 @@ void NetworkGameLoop()
 			}
 		}
 
-#ifdef DEBUG_DUMP_COMMANDS
-		/* Loading of the debug commands from -ddesync>=1 */
-		static FILE *f = FioFOpenFile("commands.log", "rb", SAVE_DIR);
-		static Date next_date = 0;
-		static uint32 next_date_fract;
-		static uint8 next_tick_skip_counter;
-		static CommandPacket *cp = NULL;
-		static bool check_sync_state = false;
-		static uint32 sync_state[2];
-		if (f == NULL && next_date == 0) {
-			DEBUG(net, 0, "Cannot open commands.log");
-			next_date = 1;
-		}
-
-		while (f != NULL && !feof(f)) {
-			if (_date == next_date && _date_fract == next_date_fract) {
-				if (cp != NULL) {
-					NetworkSendCommand(cp->tile, cp->p1, cp->p2, cp->cmd & ~CMD_FLAGS_MASK, NULL, cp->text, cp->company);
-					DEBUG(net, 0, "injecting: date{%08x; %02x; %02x}; %02x; %06x; %08x; %08x; %08x; \"%s\" (%s)", _date, _date_fract, _tick_skip_counter, (int)_current_company, cp->tile, cp->p1, cp->p2, cp->cmd, cp->text, GetCommandName(cp->cmd));
-					free(cp);
-					cp = NULL;
-				}
-				if (check_sync_state) {
-					if (sync_state[0] == _random.state[0] && sync_state[1] == _random.state[1]) {
-						DEBUG(net, 0, "sync check: date{%08x; %02x; %02x}; match", _date, _date_fract, _tick_skip_counter);
-					} else {
-						DEBUG(net, 0, "sync check: date{%08x; %02x; %02x}; mismatch expected {%08x, %08x}, got {%08x, %08x}",
-									_date, _date_fract, _tick_skip_counter, sync_state[0], sync_state[1], _random.state[0], _random.state[1]);
-						NOT_REACHED();
-					}
-					check_sync_state = false;
-				}
-			}
+		if (_network_replaying) NetworkReplayCommandLog();
 
-			if (cp != NULL || check_sync_state) break;
-
-			char buff[4096];
-			if (fgets(buff, lengthof(buff), f) == NULL) break;
-
-			char *p = buff;
-			/* Ignore the "[date time] " part of the message */
-			if (*p == '[') {
-				p = strchr(p, ']');
-				if (p == NULL) break;
-				p += 2;
-			}
-
-			if (strncmp(p, "cmd: ", 5) == 0
-#ifdef DEBUG_FAILED_DUMP_COMMANDS
-				|| strncmp(p, "cmdf: ", 6) == 0
-#endif
-				) {
-				p += 5;
-				if (*p == ' ') p++;
-				cp = CallocT<CommandPacket>(1);
-				int company;
-				int ret = sscanf(p, "date{%x; %x; %x}; %x; %x; %x; %x; %x; \"%[^\"]\"", &next_date, &next_date_fract, &next_tick_skip_counter, &company, &cp->tile, &cp->p1, &cp->p2, &cp->cmd, cp->text);
-				/* There are 9 pieces of data to read, however the last is a
-				 * string that might or might not exist. Ignore it if that
-				 * string misses because in 99% of the time it's not used. */
-				assert(ret == 9 || ret == 8);
-				cp->company = (CompanyID)company;
-			} else if (strncmp(p, "join: ", 6) == 0) {
-				/* Manually insert a pause when joining; this way the client can join at the exact right time. */
-				int ret = sscanf(p + 6, "date{%x; %x; %x}", &next_date, &next_date_fract, &next_tick_skip_counter);
-				assert(ret == 3);
-				DEBUG(net, 0, "injecting pause for join at date{%08x; %02x; %02x}; please join when paused", next_date, next_date_fract, next_tick_skip_counter);
-				cp = CallocT<CommandPacket>(1);
-				cp->company = COMPANY_SPECTATOR;
-				cp->cmd = CMD_PAUSE;
-				cp->p1 = PM_PAUSED_NORMAL;
-				cp->p2 = 1;
-				_ddc_fastforward = false;
-			} else if (strncmp(p, "sync: ", 6) == 0) {
-				int ret = sscanf(p + 6, "date{%x; %x; %x}; %x; %x", &next_date, &next_date_fract, &next_tick_skip_counter, &sync_state[0], &sync_state[1]);
-				assert(ret == 5);
-				check_sync_state = true;
-			} else if (strncmp(p, "msg: ", 5) == 0 || strncmp(p, "client: ", 8) == 0 ||
-						strncmp(p, "load: ", 6) == 0 || strncmp(p, "save: ", 6) == 0) {
-				/* A message that is not very important to the log playback, but part of the log. */
-#ifndef DEBUG_FAILED_DUMP_COMMANDS
-			} else if (strncmp(p, "cmdf: ", 6) == 0) {
-				DEBUG(net, 0, "Skipping replay of failed command: %s", p + 6);
-#endif
-			} else {
-				/* Can't parse a line; what's wrong here? */
-				DEBUG(net, 0, "trying to parse: %s", p);
-				NOT_REACHED();
-			}
-		}
-		if (f != NULL && feof(f)) {
-			DEBUG(net, 0, "End of commands.log");
-			fclose(f);
-			f = NULL;
-		}
-#endif /* DEBUG_DUMP_COMMANDS */
 		if (_frame_counter >= _frame_counter_max) {
 			/* Only check for active clients just before we're going to send out
 			 * the commands so we don't send multiple pause/unpause commands when
@@ -1020,6 +1071,11 @@ void NetworkGameLoop()
 		/* Then we make the frame */
 		StateGameLoop();
 
+		if (_network_replaying && ++_network_replay_tick_count == _network_replay_ticks) {
+			NetworkReplayReport();
+			_exit_game = true;
+		}
+
 		_sync_seed_1 = _random.state[0];
 #ifdef NETWORK_SEND_DOUBLE_SEED
 		_sync_seed_2 = _random.state[1];
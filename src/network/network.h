@@ -25,6 +25,7 @@ extern bool _network_server;     ///< network-server is active
 extern bool _network_available;  ///< is network mode available?
 extern bool _network_dedicated;  ///< are we a dedicated server?
 extern bool _is_network_server;  ///< Does this client wants to be a network-server?
+extern bool _network_replaying;  ///< Are we replaying a command log?
 
 #else /* ENABLE_NETWORK */
 /* Network function stubs when networking is disabled */
@@ -39,6 +40,7 @@ static inline bool HasClients() { return false; }
 #define _network_available 0
 #define _network_dedicated 0
 #define _is_network_server 0
+#define _network_replaying 0
 
 #endif /* ENABLE_NETWORK */
 #endif /* NETWORK_H */
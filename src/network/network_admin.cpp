@@ -24,6 +24,7 @@
 #include "../map_func.h"
 #include "../rev.h"
 #include "../game/game.hpp"
+#include "../tick_timing.h"
 
 #include "../safeguards.h"
 
@@ -56,6 +57,7 @@ static const AdminUpdateFrequency _admin_update_type_frequencies[] = {
 	ADMIN_FREQUENCY_POLL,                                                                                                                                  ///< ADMIN_UPDATE_CMD_NAMES
 	                       ADMIN_FREQUENCY_AUTOMATIC,                                                                                                      ///< ADMIN_UPDATE_CMD_LOGGING
 	                       ADMIN_FREQUENCY_AUTOMATIC,                                                                                                      ///< ADMIN_UPDATE_GAMESCRIPT
+	ADMIN_FREQUENCY_POLL | ADMIN_FREQUENCY_DAILY | ADMIN_FREQUENCY_WEEKLY | ADMIN_FREQUENCY_MONTHLY | ADMIN_FREQUENCY_QUARTERLY | ADMIN_FREQUENCY_ANUALLY, ///< ADMIN_UPDATE_TICK_TIMINGS
 };
 /** Sanity check. */
 assert_compile(lengthof(_admin_update_type_frequencies) == ADMIN_UPDATE_END);
@@ -465,6 +467,34 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::SendCompanyStats()
 	return NETWORK_RECV_STATUS_OKAY;
 }
 
+/** Send the time spent in the parts of the game tick. */
+NetworkRecvStatus ServerNetworkAdminSocketHandler::SendTickTimings()
+{
+	for (uint i = 0; i < TTP_END; i++) {
+		TickTimingStats stats;
+		GetTickTimingStats((TickTimingPhase)i, &stats);
+
+		Packet *p = new Packet(ADMIN_PACKET_SERVER_TICK_TIMINGS);
+
+		p->Send_uint8 (i);
+		p->Send_string(GetTickTimingName((TickTimingPhase)i));
+		p->Send_uint16(stats.samples);
+		p->Send_uint32(stats.average);
+		p->Send_uint32(stats.median);
+		p->Send_uint32(stats.p99);
+		p->Send_uint32(stats.max);
+
+		p->Send_uint8 (TICK_TIMING_BUCKETS);
+		for (uint j = 0; j < TICK_TIMING_BUCKETS; j++) {
+			p->Send_uint16(stats.buckets[j]);
+		}
+
+		this->SendPacket(p);
+	}
+
+	return NETWORK_RECV_STATUS_OKAY;
+}
+
 /**
  * Send a chat message.
  * @param action The action associated with the message.
@@ -778,6 +808,11 @@ NetworkRecvStatus ServerNetworkAdminSocketHandler::Receive_ADMIN_POLL(Packet *p)
 			this->SendCmdNames();
 			break;
 
+		case ADMIN_UPDATE_TICK_TIMINGS:
+			/* The admin is requesting the tick timings. */
+			this->SendTickTimings();
+			break;
+
 		default:
 			/* An unsupported "poll" update type. */
 			DEBUG(net, 3, "[admin] Not supported poll %d (%d) from '%s' (%s).", type, d1, this->admin_name, this->admin_version);
@@ -1039,6 +1074,10 @@ void NetworkAdminUpdate(AdminUpdateFrequency freq)
 						as->SendCompanyStats();
 						break;
 
+					case ADMIN_UPDATE_TICK_TIMINGS:
+						as->SendTickTimings();
+						break;
+
 					default: NOT_REACHED();
 				}
 			}
@@ -183,20 +183,20 @@ void NetworkSendCommand(TileIndex tile, uint32 p1, uint32 p2, uint32 cmd, Comman
 }
 
 /**
- * Sync our local command queue to the command queue of the given
- * socket. This is needed for the case where we receive a command
- * before saving the game for a joining client, but without the
- * execution of those commands. Not syncing those commands means
- * that the client will never get them and as such will be in a
- * desynced state from the time it started with joining.
- * @param cs The client to sync the queue to.
+ * Sync our local command queue to the given command queue. This
+ * is needed for the case where we receive a command before saving
+ * the game for a joining client, but without the execution of those
+ * commands. Not syncing those commands means that the client will
+ * never get them and as such will be in a desynced state from the
+ * time it started with joining.
+ * @param queue The queue of the map snapshot to sync the commands to.
  */
-void NetworkSyncCommandQueue(NetworkClientSocket *cs)
+void NetworkSyncCommandQueue(CommandQueue &queue)
 {
 	for (CommandPacket *p = _local_execution_queue.Peek(); p != NULL; p = p->next) {
 		CommandPacket c = *p;
 		c.callback = 0;
-		cs->outgoing_queue.Append(&c);
+		queue.Append(&c);
 	}
 }
 
@@ -267,6 +267,8 @@ static void DistributeCommandPacket(CommandPacket &cp, const NetworkClientSocket
 	cp.callback = (cs != owner) ? NULL : callback;
 	cp.my_cmd = (cs == owner);
 	_local_execution_queue.Append(&cp);
+
+	NetworkServerRecordSnapshotCommand(cp);
 }
 
 /**
@@ -276,12 +278,8 @@ static void DistributeCommandPacket(CommandPacket &cp, const NetworkClientSocket
  */
 static void DistributeQueue(CommandQueue *queue, const NetworkClientSocket *owner)
 {
-#ifdef DEBUG_DUMP_COMMANDS
 	/* When replaying we do not want this limitation. */
-	int to_go = UINT16_MAX;
-#else
-	int to_go = _settings_client.network.commands_per_frame;
-#endif
+	int to_go = _network_replaying ? UINT16_MAX : _settings_client.network.commands_per_frame;
 
 	CommandPacket *cp;
 	while (--to_go >= 0 && (cp = queue->Pop(true)) != NULL) {
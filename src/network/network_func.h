@@ -13,10 +13,9 @@
 #define NETWORK_FUNC_H
 
 /**
- * Uncomment the following define to enable command replaying.
- * See docs/desync.txt for details.
+ * Uncomment the following define to also replay failed commands
+ * when replaying a command log. See docs/desync.txt for details.
  */
-// #define DEBUG_DUMP_COMMANDS
 // #define DEBUG_FAILED_DUMP_COMMANDS
 
 #include "core/address.h"
@@ -38,6 +37,8 @@ extern uint8 _network_reconnect;
 extern StringList _network_bind_list;
 extern StringList _network_host_list;
 extern StringList _network_ban_list;
+extern char *_network_replay_file;
+extern uint32 _network_replay_ticks;
 
 byte NetworkSpectatorCount();
 void NetworkUpdateClientName();
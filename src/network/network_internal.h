@@ -45,11 +45,7 @@
  * you are doing, i.e. debugging a desync.
  * See docs/desync.txt for details.
  */
-#ifdef DEBUG_DUMP_COMMANDS
 extern bool _ddc_fastforward;
-#else
-#define _ddc_fastforward (false)
-#endif /* DEBUG_DUMP_COMMANDS */
 
 typedef class ServerNetworkGameSocketHandler NetworkClientSocket;
 
@@ -162,7 +158,8 @@ struct CommandPacket : CommandContainer {
 void NetworkDistributeCommands();
 void NetworkExecuteLocalCommandQueue();
 void NetworkFreeLocalCommandQueue();
-void NetworkSyncCommandQueue(NetworkClientSocket *cs);
+void NetworkSyncCommandQueue(CommandQueue &queue);
+void NetworkServerRecordSnapshotCommand(const CommandPacket &cp);
 
 void NetworkError(StringID error_string);
 void NetworkTextMessage(NetworkAction action, TextColour colour, bool self_send, const char *name, const char *str = "", NetworkTextMessageData data = NetworkTextMessageData());
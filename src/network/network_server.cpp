@@ -32,6 +32,8 @@
 #include "../core/pool_func.hpp"
 #include "../core/random_func.hpp"
 #include "../rev.h"
+#include <mutex>
+#include <vector>
 
 #include "../safeguards.h"
 
@@ -54,164 +56,91 @@ INSTANTIATE_POOL_METHODS(NetworkClientSocket)
 /** Instantiate the listen sockets. */
 template SocketList TCPListenHandler<ServerNetworkGameSocketHandler, PACKET_SERVER_FULL, PACKET_SERVER_BANNED>::sockets;
 
-/** Writing a savegame directly to a number of packets. */
-struct PacketWriter : SaveFilter {
-	ServerNetworkGameSocketHandler *cs; ///< Socket we are associated with.
-	Packet *current;                    ///< The packet we're currently writing to.
-	size_t total_size;                  ///< Total size of the compressed savegame.
-	Packet *packets;                    ///< Packet queue of the savegame; send these "slowly" to the client.
-	ThreadMutex *mutex;                 ///< Mutex for making threaded saving safe.
+/** Number of frames after which clients requesting the map no longer attach to an existing snapshot. */
+static const uint32 MAP_SNAPSHOT_MAX_AGE = 10 * DAY_TICKS;
 
-	/**
-	 * Create the packet writer.
-	 * @param cs The socket handler we're making the packets for.
-	 */
-	PacketWriter(ServerNetworkGameSocketHandler *cs) : SaveFilter(NULL), cs(cs), current(NULL), total_size(0), packets(NULL)
-	{
-		this->mutex = ThreadMutex::New();
-	}
-
-	/** Make sure everything is cleaned up. */
-	~PacketWriter()
-	{
-		if (this->mutex != NULL) this->mutex->BeginCritical();
-
-		if (this->cs != NULL && this->mutex != NULL) {
-			this->mutex->WaitForSignal();
-		}
-
-		/* This must all wait until the Destroy function is called. */
-
-		while (this->packets != NULL) {
-			Packet *p = this->packets->next;
-			delete this->packets;
-			this->packets = p;
-		}
-
-		delete this->current;
-
-		if (this->mutex != NULL) this->mutex->EndCritical();
-
-		delete this->mutex;
-		this->mutex = NULL;
-	}
-
-	/**
-	 * Begin the destruction of this packet writer. It can happen in two ways:
-	 * in the first case the client disconnected while saving the map. In this
-	 * case the saving has not finished and killed this PacketWriter. In that
-	 * case we simply set cs to NULL, triggering the appending to fail due to
-	 * the connection problem and eventually triggering the destructor. In the
-	 * second case the destructor is already called, and it is waiting for our
-	 * signal which we will send. Only then the packets will be removed by the
-	 * destructor.
-	 */
-	void Destroy()
-	{
-		if (this->mutex != NULL) this->mutex->BeginCritical();
-
-		this->cs = NULL;
+/**
+ * Compressed savegame of the game state at the start of a frame.
+ * All clients that request the map while the snapshot is recent download the same snapshot, each at its own pace.
+ * Clients attaching later get the commands distributed since the snapshot was made replayed.
+ * The snapshot is kept alive by the clients downloading it, and freed when the last of them is done.
+ */
+struct NetworkMapSnapshot {
+	uint32 frame;           ///< Frame counter at the time the snapshot was made.
+	CommandQueue commands;  ///< Commands to be executed after the snapshot, for clients attaching to it.
+	std::mutex mutex;       ///< Mutex for the members below, as they are written by the saving thread.
+	std::vector<byte> data; ///< Compressed savegame data written so far.
+	bool finished;          ///< Whether the whole savegame has been written.
+	bool failed;            ///< Whether writing the savegame failed.
+
+	NetworkMapSnapshot(uint32 frame) : frame(frame), finished(false), failed(false) {}
+};
 
-		if (this->mutex != NULL) this->mutex->SendSignal();
+/** The most recent map snapshot, while any client is still downloading it. */
+static std::weak_ptr<NetworkMapSnapshot> _network_map_snapshot;
 
-		if (this->mutex != NULL) this->mutex->EndCritical();
+/**
+ * Record a distributed command for the clients that may still attach to the most recent map snapshot.
+ * @param cp The command.
+ */
+void NetworkServerRecordSnapshotCommand(const CommandPacket &cp)
+{
+	std::shared_ptr<NetworkMapSnapshot> snapshot = _network_map_snapshot.lock();
+	if (!snapshot || _frame_counter - snapshot->frame > MAP_SNAPSHOT_MAX_AGE) return;
 
-		/* Make sure the saving is completely cancelled. Yes,
-		 * we need to handle the save finish as well as the
-		 * next connection might just be requesting a map. */
-		WaitTillSaved();
-		ProcessAsyncSaveFinish();
-	}
+	/* None of these commands can be from the clients attaching later. */
+	CommandPacket c = cp;
+	c.callback = NULL;
+	c.my_cmd = false;
+	snapshot->commands.Append(&c);
+}
 
-	/**
-	 * Checks whether there are packets.
-	 * It's not 100% threading safe, but this is only asked for when checking
-	 * whether there still is something to send. Then another call will be made
-	 * to actually get the Packet, which will be the only one popping packets
-	 * and thus eventually setting this on false.
-	 */
-	bool HasPackets()
-	{
-		return this->packets != NULL;
-	}
+/** Writing a savegame into a map snapshot. */
+struct NetworkMapSnapshotWriter : SaveFilter {
+	std::weak_ptr<NetworkMapSnapshot> snapshot; ///< Snapshot we are writing; the writer does not keep it alive.
+	bool finished;                              ///< Whether the whole savegame has been written.
 
 	/**
-	 * Pop a single created packet from the queue with packets.
+	 * Create the snapshot writer.
+	 * @param snapshot The snapshot to write the savegame to.
 	 */
-	Packet *PopPacket()
+	NetworkMapSnapshotWriter(const std::shared_ptr<NetworkMapSnapshot> &snapshot) : SaveFilter(NULL), snapshot(snapshot), finished(false)
 	{
-		if (this->mutex != NULL) this->mutex->BeginCritical();
-
-		Packet *p = this->packets;
-		this->packets = p->next;
-		p->next = NULL;
-
-		if (this->mutex != NULL) this->mutex->EndCritical();
-
-		return p;
 	}
 
-	/** Append the current packet to the queue. */
-	void AppendQueue()
+	/** Mark the snapshot as failed when the saving was aborted. */
+	~NetworkMapSnapshotWriter()
 	{
-		if (this->current == NULL) return;
+		if (this->finished) return;
 
-		Packet **p = &this->packets;
-		while (*p != NULL) {
-			p = &(*p)->next;
-		}
-		*p = this->current;
+		std::shared_ptr<NetworkMapSnapshot> snapshot = this->snapshot.lock();
+		if (!snapshot) return;
 
-		this->current = NULL;
+		std::lock_guard<std::mutex> lock(snapshot->mutex);
+		snapshot->failed = true;
 	}
 
 	/* virtual */ void Write(byte *buf, size_t size)
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == NULL) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
-
-		if (this->current == NULL) this->current = new Packet(PACKET_SERVER_MAP_DATA);
-
-		if (this->mutex != NULL) this->mutex->BeginCritical();
+		std::shared_ptr<NetworkMapSnapshot> snapshot = this->snapshot.lock();
 
-		byte *bufe = buf + size;
-		while (buf != bufe) {
-			size_t to_write = min(SEND_MTU - this->current->size, bufe - buf);
-			memcpy(this->current->buffer + this->current->size, buf, to_write);
-			this->current->size += (PacketSize)to_write;
-			buf += to_write;
+		/* We want to abort the saving when all clients downloading the snapshot are gone. */
+		if (!snapshot) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
-			if (this->current->size == SEND_MTU) {
-				this->AppendQueue();
-				if (buf != bufe) this->current = new Packet(PACKET_SERVER_MAP_DATA);
-			}
-		}
-
-		if (this->mutex != NULL) this->mutex->EndCritical();
-
-		this->total_size += size;
+		std::lock_guard<std::mutex> lock(snapshot->mutex);
+		snapshot->data.insert(snapshot->data.end(), buf, buf + size);
 	}
 
 	/* virtual */ void Finish()
 	{
-		/* We want to abort the saving when the socket is closed. */
-		if (this->cs == NULL) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
-
-		if (this->mutex != NULL) this->mutex->BeginCritical();
+		std::shared_ptr<NetworkMapSnapshot> snapshot = this->snapshot.lock();
 
-		/* Make sure the last packet is flushed. */
-		this->AppendQueue();
+		/* We want to abort the saving when all clients downloading the snapshot are gone. */
+		if (!snapshot) SlError(STR_NETWORK_ERROR_LOSTCONNECTION);
 
-		/* Add a packet stating that this is the end to the queue. */
-		this->current = new Packet(PACKET_SERVER_MAP_DONE);
-		this->AppendQueue();
-
-		/* Fast-track the size to the client. */
-		Packet *p = new Packet(PACKET_SERVER_MAP_SIZE);
-		p->Send_uint32((uint32)this->total_size);
-		this->cs->NetworkTCPSocketHandler::SendPacket(p);
-
-		if (this->mutex != NULL) this->mutex->EndCritical();
+		std::lock_guard<std::mutex> lock(snapshot->mutex);
+		snapshot->finished = true;
+		this->finished = true;
 	}
 };
 
@@ -220,7 +149,7 @@ struct PacketWriter : SaveFilter {
  * Create a new socket for the server side of the game connection.
  * @param s The socket to connect with.
  */
-ServerNetworkGameSocketHandler::ServerNetworkGameSocketHandler(SOCKET s) : NetworkGameSocketHandler(s)
+ServerNetworkGameSocketHandler::ServerNetworkGameSocketHandler(SOCKET s) : NetworkGameSocketHandler(s), savegame_sent(0), savegame_packets_per_send(0), savegame_size_sent(false)
 {
 	this->status = STATUS_INACTIVE;
 	this->client_id = _network_client_id++;
@@ -239,11 +168,6 @@ ServerNetworkGameSocketHandler::~ServerNetworkGameSocketHandler()
 {
 	if (_redirect_console_to_client == this->client_id) _redirect_console_to_client = INVALID_CLIENT_ID;
 	OrderBackup::ResetUser(this->client_id);
-
-	if (this->savegame != NULL) {
-		this->savegame->Destroy();
-		this->savegame = NULL;
-	}
 }
 
 Packet *ServerNetworkGameSocketHandler::ReceivePacket()
@@ -553,102 +477,103 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendWelcome()
 	return this->SendClientInfo(NetworkClientInfo::GetByClientID(CLIENT_ID_SERVER));
 }
 
-/** Tell the client that its put in a waiting queue. */
-NetworkRecvStatus ServerNetworkGameSocketHandler::SendWait()
-{
-	int waiting = 0;
-	NetworkClientSocket *new_cs;
-	Packet *p;
-
-	/* Count how many clients are waiting in the queue, in front of you! */
-	FOR_ALL_CLIENT_SOCKETS(new_cs) {
-		if (new_cs->status != STATUS_MAP_WAIT) continue;
-		if (new_cs->GetInfo()->join_date < this->GetInfo()->join_date || (new_cs->GetInfo()->join_date == this->GetInfo()->join_date && new_cs->client_id < this->client_id)) waiting++;
-	}
-
-	p = new Packet(PACKET_SERVER_WAIT);
-	p->Send_uint8(waiting);
-	this->SendPacket(p);
-	return NETWORK_RECV_STATUS_OKAY;
-}
-
 /** This sends the map to the client */
 NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 {
-	static uint sent_packets; // How many packets we did send successfully last time
-
 	if (this->status < STATUS_AUTHORIZED) {
 		/* Illegal call, return error and ignore the packet */
 		return this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
 	}
 
-	if (this->status == STATUS_AUTHORIZED) {
-		this->savegame = new PacketWriter(this);
+	if (this->status == STATUS_AUTHORIZED || this->status == STATUS_MAP_WAIT) {
+		/* Attach to the snapshot other clients are downloading, unless it is too old or failed. */
+		this->savegame = _network_map_snapshot.lock();
+		if (this->savegame && _frame_counter - this->savegame->frame > MAP_SNAPSHOT_MAX_AGE) this->savegame.reset();
+		if (this->savegame) {
+			std::lock_guard<std::mutex> lock(this->savegame->mutex);
+			if (this->savegame->failed) this->savegame.reset();
+		}
+
+		if (!this->savegame) {
+			/* Saving now would block the game until the savegame being written is done; try again next tick. */
+			if (IsSaveInProgress()) {
+				this->status = STATUS_MAP_WAIT;
+				return NETWORK_RECV_STATUS_OKAY;
+			}
+
+			this->savegame = std::make_shared<NetworkMapSnapshot>(_frame_counter);
+			_network_map_snapshot = this->savegame;
+			NetworkSyncCommandQueue(this->savegame->commands);
+			if (SaveWithFilter(new NetworkMapSnapshotWriter(this->savegame), true) != SL_OK) usererror("network savedump failed");
+		}
+
+		this->savegame_sent = 0;
+		this->savegame_packets_per_send = 4; // We start with trying 4 packets
+		this->savegame_size_sent = false;
 
 		/* Now send the _frame_counter and how many packets are coming */
 		Packet *p = new Packet(PACKET_SERVER_MAP_BEGIN);
-		p->Send_uint32(_frame_counter);
+		p->Send_uint32(this->savegame->frame);
 		this->SendPacket(p);
 
-		NetworkSyncCommandQueue(this);
+		/* The client needs all commands executed after the snapshot; from now on they are distributed to it directly. */
+		for (CommandPacket *cp = this->savegame->commands.Peek(); cp != NULL; cp = cp->next) {
+			this->outgoing_queue.Append(cp);
+		}
 		this->status = STATUS_MAP;
 		/* Mark the start of download */
 		this->last_frame = _frame_counter;
 		this->last_frame_server = _frame_counter;
-
-		sent_packets = 4; // We start with trying 4 packets
-
-		/* Make a dump of the current game */
-		if (SaveWithFilter(this->savegame, true) != SL_OK) usererror("network savedump failed");
 	}
 
 	if (this->status == STATUS_MAP) {
+		static const size_t MAP_DATA_PER_PACKET = SEND_MTU - sizeof(PacketSize) - sizeof(PacketType);
+
 		bool last_packet = false;
 		bool has_packets = false;
+		bool failed;
+
+		{
+			std::lock_guard<std::mutex> lock(this->savegame->mutex);
+			const std::vector<byte> &data = this->savegame->data;
+			bool finished = this->savegame->finished;
+			failed = this->savegame->failed;
+
+			if (finished && !this->savegame_size_sent) {
+				/* Fast-track the size to the client. */
+				Packet *p = new Packet(PACKET_SERVER_MAP_SIZE);
+				p->Send_uint32((uint32)data.size());
+				this->SendPacket(p);
+				this->savegame_size_sent = true;
+			}
 
-		for (uint i = 0; (has_packets = this->savegame->HasPackets()) && i < sent_packets; i++) {
-			Packet *p = this->savegame->PopPacket();
-			last_packet = p->buffer[2] == PACKET_SERVER_MAP_DONE;
+			/* Send only full packets until the savegame is finished, just like when it is being written. */
+			for (uint i = 0; (has_packets = (data.size() - this->savegame_sent >= MAP_DATA_PER_PACKET || (finished && this->savegame_sent < data.size()))) && i < this->savegame_packets_per_send; i++) {
+				size_t to_write = min(MAP_DATA_PER_PACKET, data.size() - this->savegame_sent);
 
-			this->SendPacket(p);
+				Packet *p = new Packet(PACKET_SERVER_MAP_DATA);
+				memcpy(p->buffer + p->size, data.data() + this->savegame_sent, to_write);
+				p->size += (PacketSize)to_write;
+				this->savegame_sent += to_write;
+				this->SendPacket(p);
+			}
 
-			if (last_packet) {
-				/* There is no more data, so break the for */
-				break;
+			if (finished && this->savegame_sent == data.size()) {
+				/* Add a packet stating that this is the end. */
+				this->SendPacket(new Packet(PACKET_SERVER_MAP_DONE));
+				last_packet = true;
 			}
 		}
 
+		if (failed) return this->SendError(NETWORK_ERROR_GENERAL);
+
 		if (last_packet) {
-			/* Done reading, make sure saving is done as well */
-			this->savegame->Destroy();
-			this->savegame = NULL;
+			/* Done reading, release our reference to the snapshot */
+			this->savegame.reset();
 
 			/* Set the status to DONE_MAP, no we will wait for the client
 			 *  to send it is ready (maybe that happens like never ;)) */
 			this->status = STATUS_DONE_MAP;
-
-			/* Find the best candidate for joining, i.e. the first joiner. */
-			NetworkClientSocket *new_cs;
-			NetworkClientSocket *best = NULL;
-			FOR_ALL_CLIENT_SOCKETS(new_cs) {
-				if (new_cs->status == STATUS_MAP_WAIT) {
-					if (best == NULL || best->GetInfo()->join_date > new_cs->GetInfo()->join_date || (best->GetInfo()->join_date == new_cs->GetInfo()->join_date && best->client_id > new_cs->client_id)) {
-						best = new_cs;
-					}
-				}
-			}
-
-			/* Is there someone else to join? */
-			if (best != NULL) {
-				/* Let the first start joining. */
-				best->status = STATUS_AUTHORIZED;
-				best->SendMap();
-
-				/* And update the rest. */
-				FOR_ALL_CLIENT_SOCKETS(new_cs) {
-					if (new_cs->status == STATUS_MAP_WAIT) new_cs->SendWait();
-				}
-			}
 		}
 
 		switch (this->SendPackets()) {
@@ -656,8 +581,8 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 				return NETWORK_RECV_STATUS_CONN_LOST;
 
 			case SPS_ALL_SENT:
-				/* All are sent, increase the sent_packets */
-				if (has_packets) sent_packets *= 2;
+				/* All are sent, increase the number of packets to send */
+				if (has_packets) this->savegame_packets_per_send *= 2;
 				break;
 
 			case SPS_PARTLY_SENT:
@@ -665,8 +590,8 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::SendMap()
 				break;
 
 			case SPS_NONE_SENT:
-				/* Not everything is sent, decrease the sent_packets */
-				if (sent_packets > 1) sent_packets /= 2;
+				/* Not everything is sent, decrease the number of packets to send */
+				if (this->savegame_packets_per_send > 1) this->savegame_packets_per_send /= 2;
 				break;
 		}
 	}
@@ -1017,22 +942,12 @@ NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_COMPANY_PASSWOR
 
 NetworkRecvStatus ServerNetworkGameSocketHandler::Receive_CLIENT_GETMAP(Packet *p)
 {
-	NetworkClientSocket *new_cs;
 	/* The client was never joined.. so this is impossible, right?
 	 *  Ignore the packet, give the client a warning, and close his connection */
 	if (this->status < STATUS_AUTHORIZED || this->HasClientQuit()) {
 		return this->SendError(NETWORK_ERROR_NOT_AUTHORIZED);
 	}
 
-	/* Check if someone else is receiving the map */
-	FOR_ALL_CLIENT_SOCKETS(new_cs) {
-		if (new_cs->status == STATUS_MAP) {
-			/* Tell the new client to wait */
-			this->status = STATUS_MAP_WAIT;
-			return this->SendWait();
-		}
-	}
-
 	/* We receive a request to upload the map.. give it to the client! */
 	return this->SendMap();
 }
@@ -1909,7 +1824,9 @@ void NetworkServer_Tick(bool send_frame)
 
 			case NetworkClientSocket::STATUS_MAP_WAIT:
 				/* This is an internal state where we do not wait
-				 * on the client to move to a different state. */
+				 * on the client to move to a different state, but
+				 * on a savegame being written to finish. */
+				if (cs->SendMap() != NETWORK_RECV_STATUS_OKAY) continue;
 				break;
 
 			case NetworkClientSocket::STATUS_END:
@@ -17,6 +17,9 @@
 #include "network_internal.h"
 #include "core/tcp_listen.h"
 #include "../thread/thread.h"
+#include <memory>
+
+struct NetworkMapSnapshot;
 
 class ServerNetworkGameSocketHandler;
 /** Make the code look slightly nicer/simpler. */
@@ -48,7 +51,6 @@ protected:
 	NetworkRecvStatus SendCompanyInfo();
 	NetworkRecvStatus SendNewGRFCheck();
 	NetworkRecvStatus SendWelcome();
-	NetworkRecvStatus SendWait();
 	NetworkRecvStatus SendNeedGamePassword();
 	NetworkRecvStatus SendNeedCompanyPassword();
 
@@ -60,7 +62,7 @@ public:
 		STATUS_AUTH_GAME,     ///< The client is authorizing with game (server) password.
 		STATUS_AUTH_COMPANY,  ///< The client is authorizing with company password.
 		STATUS_AUTHORIZED,    ///< The client is authorized.
-		STATUS_MAP_WAIT,      ///< The client is waiting as someone else is downloading the map.
+		STATUS_MAP_WAIT,      ///< The client waits for a savegame being written to finish, before the map can be saved for it.
 		STATUS_MAP,           ///< The client is downloading the map.
 		STATUS_DONE_MAP,      ///< The client has downloaded the map.
 		STATUS_PRE_ACTIVE,    ///< The client is catching up the delayed frames.
@@ -75,7 +77,10 @@ public:
 	CommandQueue outgoing_queue; ///< The command-queue awaiting delivery
 	int receive_limit;           ///< Amount of bytes that we can receive at this moment
 
-	struct PacketWriter *savegame; ///< Writer used to write the savegame.
+	std::shared_ptr<NetworkMapSnapshot> savegame; ///< Snapshot of the map the client is downloading.
+	size_t savegame_sent;                         ///< Number of bytes of the snapshot already sent to the client.
+	uint savegame_packets_per_send;               ///< Number of map packets to send at once, depending on how fast the client receives them.
+	bool savegame_size_sent;                      ///< Whether the size of the snapshot has been sent to the client.
 	NetworkAddress client_address; ///< IP-address of the client (so he can be banned)
 
 	ServerNetworkGameSocketHandler(SOCKET s);
@@ -18,6 +18,7 @@
 #include "newgrf_text.h"
 #include "window_func.h"
 #include "progress.h"
+#include "thread/thread_pool.h"
 #include "video/video_driver.hpp"
 #include "strings_func.h"
 #include "textfile_gui.h"
@@ -789,7 +790,7 @@ void ScanNewGRFFiles(NewGRFScanCallback *callback)
 	/* Only then can we really start, especially by marking the whole screen dirty. Get those other windows hidden!. */
 	MarkWholeScreenDirty();
 
-	if (!VideoDriver::GetInstance()->HasGUI() || !ThreadObject::New(&DoScanNewGRFFiles, callback, NULL, "ottd:newgrf-scan")) {
+	if (!VideoDriver::GetInstance()->HasGUI() || !ThreadPool::Submit(&DoScanNewGRFFiles, callback, NULL, TPTF_BLOCKING, "ottd:newgrf-scan")) {
 		_modal_progress_work_mutex->EndCritical();
 		_modal_progress_paint_mutex->EndCritical();
 		DoScanNewGRFFiles(callback);
@@ -68,10 +68,12 @@
 #include "smallmap_gui.h"
 #include "viewport_func.h"
 #include "thread/thread.h"
+#include "thread/thread_pool.h"
 #include "bridge_signal_map.h"
 
 #include "linkgraph/linkgraphschedule.h"
 #include "tracerestrict.h"
+#include "tick_timing.h"
 
 #include <stdarg.h>
 
@@ -193,6 +195,7 @@ static void ShowHelp()
 		"  -P password         = Password to join company\n"
 		"  -D [ip][:port]      = Start dedicated server\n"
 		"  -l ip[:port]        = Redirect DEBUG()\n"
+		"  -R [ticks:]log      = Replay a command log (dedicated only)\n"
 #if !defined(__MORPHOS__) && !defined(__AMIGA__) && !defined(WIN32)
 		"  -f                  = Fork into the background (dedicated only)\n"
 #endif
@@ -358,6 +361,9 @@ static void ShutdownGame()
 
 	ViewportMapClearTunnelCache();
 	ClearCommandLog();
+
+	/* After all link graph jobs have been aborted, so the workers don't have to finish them. */
+	ThreadPool::Shutdown();
 }
 
 /**
@@ -555,6 +561,7 @@ static const OptionData _options[] = {
 	 GETOPT_SHORT_VALUE('l'),
 	 GETOPT_SHORT_VALUE('p'),
 	 GETOPT_SHORT_VALUE('P'),
+	 GETOPT_SHORT_VALUE('R'),
 #if !defined(__MORPHOS__) && !defined(__AMIGA__) && !defined(WIN32)
 	 GETOPT_SHORT_NOVAL('f'),
 #endif
@@ -652,6 +659,19 @@ int openttd_main(int argc, char *argv[])
 		case 'P':
 			scanner->join_company_password = mgo.opt;
 			break;
+		case 'R': {
+			/* The log can be preceded by the number of ticks to run. */
+			char *end;
+			_network_replay_ticks = strtoul(mgo.opt, &end, 10);
+			if (end == mgo.opt || *end != ':') {
+				_network_replay_ticks = 0;
+				end = NULL;
+			}
+			free(_network_replay_file);
+			_network_replay_file = stredup(end != NULL ? end + 1 : mgo.opt);
+			_network_replaying = true;
+			break;
+		}
 #endif /* ENABLE_NETWORK */
 		case 'r': ParseResolution(&resolution, mgo.opt); break;
 		case 't': scanner->startyear = atoi(mgo.opt); break;
@@ -751,6 +771,7 @@ int openttd_main(int argc, char *argv[])
 #if defined(ENABLE_NETWORK)
 	if (dedicated) DEBUG(net, 0, "Starting dedicated version %s", _openttd_revision);
 	if (_dedicated_forks && !dedicated) _dedicated_forks = false;
+	if (_network_replaying && !dedicated) usererror("Replaying a command log requires a dedicated server (-D)");
 
 #if defined(UNIX) && !defined(__MORPHOS__)
 	/* We must fork here, or we'll end up without some resources we need (like sockets) */
@@ -758,6 +779,9 @@ int openttd_main(int argc, char *argv[])
 #endif
 #endif
 
+	/* Only after forking, as the worker threads would not survive it. */
+	ThreadPool::Init();
+
 	LoadFromConfig(true);
 
 	if (resolution.width != 0) _cur_resolution = resolution;
@@ -1517,14 +1541,14 @@ void StateGameLoop()
 	/* don't execute the state loop during pause */
 	if (_pause_mode != PM_UNPAUSED) {
 		UpdateLandscapingLimits();
-#ifndef DEBUG_DUMP_COMMANDS
-		Game::GameLoop();
-#endif
+		if (!_network_replaying) Game::GameLoop();
 		CallWindowTickEvent();
 		return;
 	}
 	if (HasModalProgress()) return;
 
+	TickTimer timer(TTP_GAME_LOOP);
+
 	Layouter::ReduceLineCache();
 
 	if (_game_mode == GM_EDITOR) {
@@ -1568,10 +1592,10 @@ void StateGameLoop()
 		}
 		BasePersistentStorageArray::SwitchMode(PSM_LEAVE_GAMELOOP);
 
-#ifndef DEBUG_DUMP_COMMANDS
-		AI::GameLoop();
-		Game::GameLoop();
-#endif
+		if (!_network_replaying) {
+			AI::GameLoop();
+			Game::GameLoop();
+		}
 		UpdateLandscapingLimits();
 
 		CallWindowTickEvent();
@@ -1624,6 +1648,9 @@ void GameLoop()
 		return;
 	}
 
+	/* Everything since the previous game loop, including drawing, belongs to the previous tick. */
+	FinishTickTimings();
+
 	ProcessAsyncSaveFinish();
 
 	/* autosave game? */
@@ -1639,7 +1666,6 @@ void GameLoop()
 		_switch_mode = SM_NONE;
 	}
 
-	IncreaseSpriteLRU();
 	InteractiveRandom();
 
 	extern int _caret_timer;
@@ -0,0 +1,374 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file water_regions.cpp Handles dividing the water in the map into regions to assist pathfinding. */
+
+#include "../stdafx.h"
+#include "../ship.h"
+#include "water_regions.h"
+#include "follow_track.hpp"
+#include "../map_func.h"
+#include "../tile_cmd.h"
+#include <memory>
+#include <queue>
+#include <unordered_map>
+#include <algorithm>
+
+#include "../safeguards.h"
+
+/** Maximum number of patches the region path search may expand before giving up. */
+static const uint WATER_REGION_MAX_SEARCH_NODES = 1 << 16;
+/** Number of patches the region path search may expand per region between origin and destination. */
+static const uint WATER_REGION_SEARCH_NODES_PER_REGION = 256;
+/** Number of region paths kept in the cache before it is cleared. */
+static const uint WATER_REGION_PATH_CACHE_SIZE = 1 << 14;
+
+/**
+ * Connectivity data of a square region of the map.
+ * The data is calculated on demand and thrown away whenever the water in the region (or at its edges) changes.
+ */
+struct WaterRegion {
+	bool initialized;                                        ///< Whether the data below is up to date.
+	uint8 number_of_patches;                                 ///< Number of connected patches of water in the region.
+	uint16 edge_traversability_bits[DIAGDIR_END];            ///< Per side, a bit for each edge tile from which ships can leave the region to that side.
+	std::unique_ptr<WaterRegionPatchLabel[]> tile_patch_labels; ///< Patch label of each tile, NULL if there is no water in the region.
+	std::vector<std::pair<WaterRegionPatchLabel, TileIndex>> aqueduct_links; ///< Patches with an aqueduct leading out of the region, and the tile the aqueduct ends at.
+
+	WaterRegion() : initialized(false), number_of_patches(0), edge_traversability_bits() {}
+};
+
+static std::vector<WaterRegion> _water_regions;
+
+/** Result of a region path search, see #FindWaterRegionPath. */
+struct WaterRegionPathCacheItem {
+	uint max_length;                        ///< Maximum path length the search was done for.
+	bool found;                             ///< Whether a path was found.
+	std::vector<WaterRegionPatchDesc> path; ///< The path, if found.
+};
+
+/** Region paths by origin and destination patch; cleared whenever any water region changes. */
+static std::unordered_map<uint64, WaterRegionPathCacheItem> _water_region_path_cache;
+
+static inline uint GetWaterRegionMapSizeX() { return MapSizeX() / WATER_REGION_EDGE_LENGTH; }
+static inline uint GetWaterRegionMapSizeY() { return MapSizeY() / WATER_REGION_EDGE_LENGTH; }
+
+static inline uint GetWaterRegionIndex(uint x, uint y)
+{
+	return y * GetWaterRegionMapSizeX() + x;
+}
+
+static inline uint GetWaterRegionIndex(TileIndex tile)
+{
+	return GetWaterRegionIndex(TileX(tile) / WATER_REGION_EDGE_LENGTH, TileY(tile) / WATER_REGION_EDGE_LENGTH);
+}
+
+static inline uint GetWaterRegionLocalIndex(TileIndex tile)
+{
+	return (TileX(tile) % WATER_REGION_EDGE_LENGTH) + (TileY(tile) % WATER_REGION_EDGE_LENGTH) * WATER_REGION_EDGE_LENGTH;
+}
+
+static inline TrackBits GetWaterTracks(TileIndex tile)
+{
+	return TrackStatusToTrackBits(GetTileTrackStatus(tile, TRANSPORT_WATER, 0));
+}
+
+/**
+ * Recalculate the patches and edge connectivity of a region.
+ * Tiles are connected using the same track follower as the ship pathfinder.
+ * @param region Region to update.
+ * @param rx X coordinate of the region, in regions.
+ * @param ry Y coordinate of the region, in regions.
+ */
+static void UpdateWaterRegion(WaterRegion &region, uint rx, uint ry)
+{
+	region.initialized = true;
+	region.number_of_patches = 0;
+	MemSetT(region.edge_traversability_bits, 0, DIAGDIR_END);
+	region.aqueduct_links.clear();
+
+	const uint x0 = rx * WATER_REGION_EDGE_LENGTH;
+	const uint y0 = ry * WATER_REGION_EDGE_LENGTH;
+
+	WaterRegionPatchLabel labels[WATER_REGION_NUMBER_OF_TILES];
+	MemSetT(labels, INVALID_WATER_REGION_PATCH, WATER_REGION_NUMBER_OF_TILES);
+	std::vector<TileIndex> tiles_to_check;
+
+	for (uint i = 0; i < WATER_REGION_NUMBER_OF_TILES; i++) {
+		if (labels[i] != INVALID_WATER_REGION_PATCH) continue;
+		TileIndex start_tile = TileXY(x0 + i % WATER_REGION_EDGE_LENGTH, y0 + i / WATER_REGION_EDGE_LENGTH);
+		if (GetWaterTracks(start_tile) == TRACK_BIT_NONE) continue;
+
+		/* Flood fill a new patch. There are at most half as many patches as tiles, so the label can't overflow. */
+		const WaterRegionPatchLabel label = ++region.number_of_patches;
+		labels[i] = label;
+		tiles_to_check.push_back(start_tile);
+		while (!tiles_to_check.empty()) {
+			TileIndex tile = tiles_to_check.back();
+			tiles_to_check.pop_back();
+
+			TrackdirBits trackdirs = TrackBitsToTrackdirBits(GetWaterTracks(tile));
+			while (trackdirs != TRACKDIR_BIT_NONE) {
+				Trackdir td = RemoveFirstTrackdir(&trackdirs);
+				CFollowTrackWater ft;
+				if (!ft.Follow(tile, td)) continue;
+
+				TileIndex next = ft.m_new_tile;
+				if (TileX(next) / WATER_REGION_EDGE_LENGTH == rx && TileY(next) / WATER_REGION_EDGE_LENGTH == ry) {
+					WaterRegionPatchLabel &next_label = labels[GetWaterRegionLocalIndex(next)];
+					if (next_label == INVALID_WATER_REGION_PATCH) {
+						next_label = label;
+						tiles_to_check.push_back(next);
+					}
+				} else if (ft.m_is_bridge) {
+					region.aqueduct_links.push_back(std::make_pair(label, next));
+				} else {
+					DiagDirection side = DiagdirBetweenTiles(tile, next);
+					uint pos = (DiagDirToAxis(side) == AXIS_X) ? TileY(tile) - y0 : TileX(tile) - x0;
+					SetBit(region.edge_traversability_bits[side], pos);
+				}
+			}
+		}
+	}
+
+	if (region.number_of_patches == 0) {
+		region.tile_patch_labels.reset();
+	} else {
+		if (!region.tile_patch_labels) region.tile_patch_labels.reset(new WaterRegionPatchLabel[WATER_REGION_NUMBER_OF_TILES]);
+		MemCpyT(region.tile_patch_labels.get(), labels, WATER_REGION_NUMBER_OF_TILES);
+	}
+}
+
+/**
+ * Get a region, updating it first if needed.
+ * @param rx X coordinate of the region, in regions.
+ * @param ry Y coordinate of the region, in regions.
+ * @return The up to date region.
+ */
+static const WaterRegion &GetUpdatedWaterRegion(uint rx, uint ry)
+{
+	WaterRegion &region = _water_regions[GetWaterRegionIndex(rx, ry)];
+	if (!region.initialized) UpdateWaterRegion(region, rx, ry);
+	return region;
+}
+
+static inline WaterRegionPatchLabel GetWaterRegionPatchLabel(const WaterRegion &region, TileIndex tile)
+{
+	return region.tile_patch_labels ? region.tile_patch_labels[GetWaterRegionLocalIndex(tile)] : INVALID_WATER_REGION_PATCH;
+}
+
+/**
+ * Get the water region patch a tile belongs to.
+ * @param tile Tile to get the patch of.
+ * @return Patch of the tile, with label INVALID_WATER_REGION_PATCH if ships can't use the tile.
+ */
+WaterRegionPatchDesc GetWaterRegionPatchInfo(TileIndex tile)
+{
+	WaterRegionPatchDesc desc;
+	desc.x = TileX(tile) / WATER_REGION_EDGE_LENGTH;
+	desc.y = TileY(tile) / WATER_REGION_EDGE_LENGTH;
+	desc.label = GetWaterRegionPatchLabel(GetUpdatedWaterRegion(desc.x, desc.y), tile);
+	return desc;
+}
+
+/**
+ * Get the patches ships can move to directly from the given patch.
+ * @param desc Patch to get the neighbours of.
+ * @param[out] neighbours Neighbouring patches, each listed once.
+ */
+static void GetWaterRegionPatchNeighbours(const WaterRegionPatchDesc &desc, std::vector<WaterRegionPatchDesc> &neighbours)
+{
+	neighbours.clear();
+	const WaterRegion &region = GetUpdatedWaterRegion(desc.x, desc.y);
+
+	const uint x0 = desc.x * WATER_REGION_EDGE_LENGTH;
+	const uint y0 = desc.y * WATER_REGION_EDGE_LENGTH;
+
+	for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) {
+		if (region.edge_traversability_bits[side] == 0) continue;
+
+		TileIndexDiffC diff = TileIndexDiffCByDiagDir(side);
+		int nx = desc.x + diff.x;
+		int ny = desc.y + diff.y;
+		if (nx < 0 || ny < 0 || nx >= (int)GetWaterRegionMapSizeX() || ny >= (int)GetWaterRegionMapSizeY()) continue;
+
+		const WaterRegion &other = GetUpdatedWaterRegion(nx, ny);
+		uint16 common_bits = region.edge_traversability_bits[side] & other.edge_traversability_bits[ReverseDiagDir(side)];
+		while (common_bits != 0) {
+			uint pos = FindFirstBit(common_bits);
+			ClrBit(common_bits, pos);
+
+			/* Tile at position pos of the edge on this side of the region. */
+			uint x = x0 + ((DiagDirToAxis(side) == AXIS_X) ? (diff.x < 0 ? 0 : WATER_REGION_EDGE_LENGTH - 1) : pos);
+			uint y = y0 + ((DiagDirToAxis(side) == AXIS_X) ? pos : (diff.y < 0 ? 0 : WATER_REGION_EDGE_LENGTH - 1));
+			TileIndex tile = TileXY(x, y);
+			if (GetWaterRegionPatchLabel(region, tile) != desc.label) continue;
+
+			WaterRegionPatchDesc neighbour;
+			neighbour.x = nx;
+			neighbour.y = ny;
+			neighbour.label = GetWaterRegionPatchLabel(other, TileXY(x + diff.x, y + diff.y));
+			if (neighbour.label == INVALID_WATER_REGION_PATCH) continue;
+			if (std::find(neighbours.begin(), neighbours.end(), neighbour) == neighbours.end()) neighbours.push_back(neighbour);
+		}
+	}
+
+	for (const auto &link : region.aqueduct_links) {
+		if (link.first != desc.label) continue;
+		WaterRegionPatchDesc neighbour = GetWaterRegionPatchInfo(link.second);
+		if (neighbour.label == INVALID_WATER_REGION_PATCH) continue;
+		if (std::find(neighbours.begin(), neighbours.end(), neighbour) == neighbours.end()) neighbours.push_back(neighbour);
+	}
+}
+
+static inline uint32 GetWaterRegionPatchKey(const WaterRegionPatchDesc &desc)
+{
+	return (GetWaterRegionIndex(desc.x, desc.y) << 8) | desc.label;
+}
+
+static inline WaterRegionPatchDesc GetWaterRegionPatchFromKey(uint32 key)
+{
+	WaterRegionPatchDesc desc;
+	uint index = key >> 8;
+	desc.x = index % GetWaterRegionMapSizeX();
+	desc.y = index / GetWaterRegionMapSizeX();
+	desc.label = GB(key, 0, 8);
+	return desc;
+}
+
+/**
+ * Search a path of water region patches between two patches.
+ * The search gives up after a number of expansions proportional to the distance between the patches.
+ * @param origin Patch to start at.
+ * @param dest Patch to find a path to.
+ * @param max_length Maximum number of patches to return, counted from the origin.
+ * @param[out] path Patches of the path, starting with \a origin.
+ * @return Whether a path was found.
+ */
+static bool SearchWaterRegionPath(const WaterRegionPatchDesc &origin, const WaterRegionPatchDesc &dest, uint max_length, std::vector<WaterRegionPatchDesc> &path)
+{
+	auto estimate = [&dest](const WaterRegionPatchDesc &desc) -> uint {
+		return Delta(desc.x, dest.x) + Delta(desc.y, dest.y);
+	};
+
+	/** Search state of a visited patch. */
+	struct VisitedPatch {
+		uint32 parent; ///< Key of the patch this patch was reached from.
+		uint cost;     ///< Number of steps from the origin.
+	};
+	std::unordered_map<uint32, VisitedPatch> visited;
+
+	/* Open list ordered by estimated total cost, ties broken by key to keep the result deterministic. */
+	typedef std::pair<uint, uint32> OpenItem;
+	std::priority_queue<OpenItem, std::vector<OpenItem>, std::greater<OpenItem>> open;
+
+	const uint32 origin_key = GetWaterRegionPatchKey(origin);
+	visited[origin_key] = { origin_key, 0 };
+	open.push(OpenItem(estimate(origin), origin_key));
+
+	std::vector<WaterRegionPatchDesc> neighbours;
+	const uint max_expanded = min(WATER_REGION_MAX_SEARCH_NODES, WATER_REGION_SEARCH_NODES_PER_REGION * (estimate(origin) + 1));
+	uint expanded = 0;
+	while (!open.empty()) {
+		const OpenItem item = open.top();
+		open.pop();
+
+		const WaterRegionPatchDesc desc = GetWaterRegionPatchFromKey(item.second);
+		const uint cost = visited[item.second].cost;
+		if (item.first != cost + estimate(desc)) continue; // superseded by a cheaper entry
+
+		if (desc == dest) {
+			for (uint32 key = item.second; key != origin_key; key = visited[key].parent) {
+				path.push_back(GetWaterRegionPatchFromKey(key));
+			}
+			path.push_back(origin);
+			std::reverse(path.begin(), path.end());
+			if (path.size() > max_length) path.resize(max_length);
+			return true;
+		}
+
+		if (++expanded > max_expanded) break;
+
+		GetWaterRegionPatchNeighbours(desc, neighbours);
+		for (const WaterRegionPatchDesc &neighbour : neighbours) {
+			const uint32 key = GetWaterRegionPatchKey(neighbour);
+			auto it = visited.find(key);
+			if (it != visited.end() && it->second.cost <= cost + 1) continue;
+			visited[key] = { item.second, cost + 1 };
+			open.push(OpenItem(cost + 1 + estimate(neighbour), key));
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Find a path of water region patches between two patches.
+ * Every step to a neighbouring region costs the same, so the path is the one crossing the fewest regions.
+ * The results, including failed searches, are cached until any water region changes.
+ * @param origin Patch to start at.
+ * @param dest Patch to find a path to.
+ * @param max_length Maximum number of patches to return, counted from the origin.
+ * @param[out] path Patches of the path, starting with \a origin.
+ * @return Whether a path was found.
+ */
+bool FindWaterRegionPath(const WaterRegionPatchDesc &origin, const WaterRegionPatchDesc &dest, uint max_length, std::vector<WaterRegionPatchDesc> &path)
+{
+	path.clear();
+	if (origin.label == INVALID_WATER_REGION_PATCH || dest.label == INVALID_WATER_REGION_PATCH) return false;
+
+	const uint64 key = ((uint64)GetWaterRegionPatchKey(origin) << 32) | GetWaterRegionPatchKey(dest);
+	auto it = _water_region_path_cache.find(key);
+	if (it != _water_region_path_cache.end() && it->second.max_length == max_length) {
+		path = it->second.path;
+		return it->second.found;
+	}
+
+	bool found = SearchWaterRegionPath(origin, dest, max_length, path);
+
+	if (_water_region_path_cache.size() >= WATER_REGION_PATH_CACHE_SIZE) _water_region_path_cache.clear();
+	WaterRegionPathCacheItem &item = _water_region_path_cache[key];
+	item.max_length = max_length;
+	item.found = found;
+	item.path = path;
+	return found;
+}
+
+/**
+ * Mark the water region of a tile as changed, it will be recalculated when it is next needed.
+ * Call this whenever the water tracks of a tile change.
+ * @param tile Changed tile.
+ */
+void InvalidateWaterRegion(TileIndex tile)
+{
+	if (_water_regions.empty() || tile >= MapSize()) return;
+
+	/* Any change can open or close a connection, so all cached paths may be wrong now. */
+	if (!_water_region_path_cache.empty()) _water_region_path_cache.clear();
+
+	const uint index = GetWaterRegionIndex(tile);
+	_water_regions[index].initialized = false;
+
+	/* The edge connectivity of a region depends on the first tiles of the neighbouring regions. */
+	for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) {
+		TileIndex adjacent = AddTileIndexDiffCWrap(tile, TileIndexDiffCByDiagDir(side));
+		if (adjacent == INVALID_TILE) continue;
+		const uint adjacent_index = GetWaterRegionIndex(adjacent);
+		if (adjacent_index != index) _water_regions[adjacent_index].initialized = false;
+	}
+}
+
+/**
+ * Allocate the water regions for the current map size, all of them to be calculated on demand.
+ */
+void AllocateWaterRegions()
+{
+	_water_regions.clear();
+	_water_regions.resize(GetWaterRegionMapSizeX() * GetWaterRegionMapSizeY());
+	_water_region_path_cache.clear();
+}
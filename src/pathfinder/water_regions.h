@@ -0,0 +1,46 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file water_regions.h Handles dividing the water in the map into regions to assist pathfinding. */
+
+#ifndef WATER_REGIONS_H
+#define WATER_REGIONS_H
+
+#include "../tile_type.h"
+#include <vector>
+
+/** Length of the edges of a water region, in tiles. */
+static const uint WATER_REGION_EDGE_LENGTH = 16;
+/** Number of tiles in a water region. */
+static const uint WATER_REGION_NUMBER_OF_TILES = WATER_REGION_EDGE_LENGTH * WATER_REGION_EDGE_LENGTH;
+
+/** Label of a connected patch of water within a water region, 0 means no water. */
+typedef uint8 WaterRegionPatchLabel;
+static const WaterRegionPatchLabel INVALID_WATER_REGION_PATCH = 0;
+
+/**
+ * Describes a single connected patch of water within a water region.
+ * Two tiles of a region belong to the same patch if ships can travel between them without leaving the region.
+ */
+struct WaterRegionPatchDesc {
+	uint x;                      ///< X coordinate of the region, in regions.
+	uint y;                      ///< Y coordinate of the region, in regions.
+	WaterRegionPatchLabel label; ///< Label of the patch within the region.
+
+	bool operator==(const WaterRegionPatchDesc &other) const { return this->x == other.x && this->y == other.y && this->label == other.label; }
+	bool operator!=(const WaterRegionPatchDesc &other) const { return !(*this == other); }
+};
+
+WaterRegionPatchDesc GetWaterRegionPatchInfo(TileIndex tile);
+bool FindWaterRegionPath(const WaterRegionPatchDesc &origin, const WaterRegionPatchDesc &dest, uint max_length, std::vector<WaterRegionPatchDesc> &path);
+
+void InvalidateWaterRegion(TileIndex tile);
+void AllocateWaterRegions();
+
+#endif /* WATER_REGIONS_H */
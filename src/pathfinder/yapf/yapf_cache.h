@@ -21,4 +21,7 @@
  */
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track);
 
+char *DumpYapfSegmentCacheStats(char *buffer, const char *last);
+void ResetYapfSegmentCacheStats();
+
 #endif /* YAPF_CACHE_H */
@@ -98,11 +98,20 @@ public:
  *  the track layout changes. It is implemented as base class because it needs
  *  to be shared between all rail YAPF types (one shared counter, one notification
  *  function.
+ *  Any change flushes the caches as a whole: a joining client starts with an empty
+ *  cache, so cached costs must always equal freshly calculated ones.
  */
 struct CSegmentCostCacheBase
 {
+	/** Number of stored segments after which a cache is flushed, to bound its memory use. */
+	static const uint MAX_SEGMENTS = 65536;
+
 	static int   s_rail_change_counter;
 
+	static uint64 s_hits;    ///< Number of global cache lookups which found a calculated segment.
+	static uint64 s_misses;  ///< Number of global cache lookups which needed to calculate the segment.
+	static uint64 s_flushes; ///< Number of times a cache was flushed.
+
 	static void NotifyTrackLayoutChange(TileIndex tile, Track track)
 	{
 		s_rail_change_counter++;
@@ -138,6 +147,7 @@ struct CSegmentCostCacheT : public CSegmentCostCacheBase {
 	{
 		m_map.Clear();
 		m_heap.Clear();
+		s_flushes++;
 	}
 
 	inline Tsegment& Get(Key &key, bool *found)
@@ -198,6 +208,8 @@ protected:
 		if (last_rail_change_counter != Cache::s_rail_change_counter) {
 			last_rail_change_counter = Cache::s_rail_change_counter;
 			C.Flush();
+		} else if (C.m_heap.Length() >= CSegmentCostCacheBase::MAX_SEGMENTS) {
+			C.Flush();
 		}
 		return C;
 	}
@@ -216,6 +228,11 @@ public:
 		bool found;
 		CachedData &item = m_global_cache.Get(key, &found);
 		Yapf().ConnectNodeToCachedData(n, item);
+		if (found && item.m_cost >= 0) {
+			Cache::s_hits++;
+		} else {
+			Cache::s_misses++;
+		}
 		return found;
 	}
 
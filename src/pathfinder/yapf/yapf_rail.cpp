@@ -711,8 +711,35 @@ bool YapfTrainFindNearestSafeTile(const Train *v, TileIndex tile, Trackdir td, b
 
 /** if any track changes, this counter is incremented - that will invalidate segment cost cache */
 int CSegmentCostCacheBase::s_rail_change_counter = 0;
+uint64 CSegmentCostCacheBase::s_hits = 0;
+uint64 CSegmentCostCacheBase::s_misses = 0;
+uint64 CSegmentCostCacheBase::s_flushes = 0;
 
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
 	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, track);
 }
+
+/**
+ * Write the statistics of the rail segment cost caches into a buffer.
+ * @param buffer Buffer to write into.
+ * @param last Last position in the buffer.
+ * @return Updated position in the buffer.
+ */
+char *DumpYapfSegmentCacheStats(char *buffer, const char *last)
+{
+	uint64 lookups = CSegmentCostCacheBase::s_hits + CSegmentCostCacheBase::s_misses;
+	buffer += seprintf(buffer, last, "Segment cost cache lookups: " OTTD_PRINTF64U ", hits: " OTTD_PRINTF64U " (%u%%), misses: " OTTD_PRINTF64U "\n",
+			lookups, CSegmentCostCacheBase::s_hits, lookups > 0 ? (uint)(CSegmentCostCacheBase::s_hits * 100 / lookups) : 0,
+			CSegmentCostCacheBase::s_misses);
+	buffer += seprintf(buffer, last, "Cache flushes: " OTTD_PRINTF64U "\n", CSegmentCostCacheBase::s_flushes);
+	return buffer;
+}
+
+/** Reset the statistics of the rail segment cost caches. */
+void ResetYapfSegmentCacheStats()
+{
+	CSegmentCostCacheBase::s_hits = 0;
+	CSegmentCostCacheBase::s_misses = 0;
+	CSegmentCostCacheBase::s_flushes = 0;
+}
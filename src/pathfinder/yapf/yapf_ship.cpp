@@ -14,9 +14,42 @@
 
 #include "yapf.hpp"
 #include "yapf_node_ship.hpp"
+#include "../water_regions.h"
+
+#include <bitset>
+#include <unordered_map>
 
 #include "../../safeguards.h"
 
+/** Number of water regions ahead of the ship the tile-level search may look at. */
+static const uint SHIP_WATER_REGION_LOOKAHEAD = 4;
+
+/**
+ * Find the corridor of water region patches the tile-level search for a ship is confined to.
+ * @param src_tile Tile the ship is coming from.
+ * @param tile Tile the ship is entering.
+ * @param dest_tile Destination of the ship.
+ * @param[out] corridor Patches the search may enter, empty if the search is not to be confined.
+ * @return Whether the destination lies beyond the corridor, so the search has to end at the last patch of the corridor.
+ */
+static bool FindShipWaterRegionCorridor(TileIndex src_tile, TileIndex tile, TileIndex dest_tile, std::vector<WaterRegionPatchDesc> &corridor)
+{
+	WaterRegionPatchDesc origin = GetWaterRegionPatchInfo(tile);
+	WaterRegionPatchDesc dest = GetWaterRegionPatchInfo(dest_tile);
+	if (origin == dest || !FindWaterRegionPath(origin, dest, SHIP_WATER_REGION_LOOKAHEAD + 1, corridor)) {
+		corridor.clear();
+		return false;
+	}
+
+	bool region_target = corridor.back() != dest;
+
+	/* The origin node of the search is on the tile the ship is coming from. */
+	WaterRegionPatchDesc src = GetWaterRegionPatchInfo(src_tile);
+	if (std::find(corridor.begin(), corridor.end(), src) == corridor.end()) corridor.insert(corridor.begin(), src);
+
+	return region_target;
+}
+
 /** Node Follower module of YAPF for ships */
 template <class Types>
 class CYapfFollowShipT
@@ -43,7 +76,7 @@ public:
 	inline void PfFollowNode(Node &old_node)
 	{
 		TrackFollower F(Yapf().GetVehicle());
-		if (F.Follow(old_node.m_key.m_tile, old_node.m_key.m_td)) {
+		if (F.Follow(old_node.m_key.m_tile, old_node.m_key.m_td) && Yapf().IsTileInCorridor(F.m_new_tile)) {
 			Yapf().AddMultipleNodes(&old_node, F);
 		}
 	}
@@ -78,17 +111,40 @@ public:
 		/* get available trackdirs on the destination tile */
 		TrackdirBits dest_trackdirs = TrackStatusToTrackdirBits(GetTileTrackStatus(v->dest_tile, TRANSPORT_WATER, 0));
 
+		/* confine the search to the water regions towards the destination */
+		std::vector<WaterRegionPatchDesc> corridor;
+		bool region_target = FindShipWaterRegionCorridor(src_tile, tile, v->dest_tile, corridor);
+
 		/* create pathfinder instance */
 		Tpf pf;
 		/* set origin and destination nodes */
 		pf.SetOrigin(src_tile, trackdirs);
 		pf.SetDestination(v->dest_tile, dest_trackdirs);
+		pf.SetCorridor(corridor, region_target);
 		/* find best path */
 		path_found = pf.FindPath(v);
 
+		if (!path_found && !corridor.empty()) {
+			/* The corridor is only a coarse approximation, search without it before giving up. */
+			Tpf pf_full;
+			pf_full.SetOrigin(src_tile, trackdirs);
+			pf_full.SetDestination(v->dest_tile, dest_trackdirs);
+			path_found = pf_full.FindPath(v);
+			return ExtractFirstTrackdir(pf_full.GetBestNode(), tile);
+		}
+		return ExtractFirstTrackdir(pf.GetBestNode(), tile);
+	}
+
+	/**
+	 * Get the trackdir of the first step of a path.
+	 * @param pNode Last node of the path, may be NULL.
+	 * @param tile Tile of the first step.
+	 * @return Trackdir of the first step, INVALID_TRACKDIR if there is no path.
+	 */
+	static Trackdir ExtractFirstTrackdir(Node *pNode, TileIndex tile)
+	{
 		Trackdir next_trackdir = INVALID_TRACKDIR; // this would mean "path not found"
 
-		Node *pNode = pf.GetBestNode();
 		if (pNode != NULL) {
 			/* walk through the path back to the origin */
 			Node *pPrevNode = NULL;
@@ -188,6 +244,105 @@ public:
 	}
 };
 
+/**
+ * Destination module of YAPF for ships. In addition to searching for the destination tile,
+ *  the search can be confined to a corridor of water region patches and end at the last
+ *  patch of the corridor, if the destination lies beyond it.
+ */
+template <class Types>
+class CYapfDestinationTileWaterT : public CYapfDestinationTileT<Types>
+{
+public:
+	typedef CYapfDestinationTileT<Types> Tbase;
+	typedef typename Types::NodeList::Titem Node; ///< this will be our node type
+
+protected:
+	/** Labels of the corridor patches within a region, indexed by label. */
+	typedef std::bitset<1 << (8 * sizeof(WaterRegionPatchLabel))> PatchLabelSet;
+
+	std::vector<WaterRegionPatchDesc> m_corridor;                 ///< patches the search may enter, empty if not confined
+	std::unordered_map<uint32, PatchLabelSet> m_corridor_patches; ///< corridor patches by region, see CorridorRegionKey
+	bool m_has_region_target;                                     ///< whether the search ends at the last patch of the corridor
+
+	/** Key of a region in #m_corridor_patches. */
+	static inline uint32 CorridorRegionKey(uint x, uint y)
+	{
+		return (x << 16) | y;
+	}
+
+public:
+	CYapfDestinationTileWaterT() : m_has_region_target(false) {}
+
+	/**
+	 * Confine the search to a corridor of water region patches.
+	 * @param corridor Patches the search may enter, empty to not confine the search.
+	 * @param region_target Whether the search ends at the last patch of the corridor instead of the destination tile.
+	 */
+	void SetCorridor(const std::vector<WaterRegionPatchDesc> &corridor, bool region_target)
+	{
+		m_corridor = corridor;
+		m_has_region_target = region_target && !corridor.empty();
+		m_corridor_patches.clear();
+		for (std::vector<WaterRegionPatchDesc>::const_iterator it = corridor.begin(); it != corridor.end(); ++it) {
+			m_corridor_patches[CorridorRegionKey(it->x, it->y)].set(it->label);
+		}
+	}
+
+	/** Check whether the search may enter the given tile. */
+	inline bool IsTileInCorridor(TileIndex tile) const
+	{
+		if (m_corridor.empty()) return true;
+		/* Only look at the patch label, which may have to update the region, for regions the corridor passes. */
+		std::unordered_map<uint32, PatchLabelSet>::const_iterator it = m_corridor_patches.find(
+				CorridorRegionKey(TileX(tile) / WATER_REGION_EDGE_LENGTH, TileY(tile) / WATER_REGION_EDGE_LENGTH));
+		if (it == m_corridor_patches.end()) return false;
+		return it->second.test(GetWaterRegionPatchInfo(tile).label);
+	}
+
+	/** Called by YAPF to detect if node ends in the desired destination */
+	inline bool PfDetectDestination(Node &n)
+	{
+		if (!m_has_region_target) return Tbase::PfDetectDestination(n);
+		return GetWaterRegionPatchInfo(n.m_key.m_tile) == m_corridor.back();
+	}
+
+	/**
+	 * Called by YAPF to calculate cost estimate. When the search ends at a water region patch,
+	 *  the estimate is the distance to the nearest tile of its region.
+	 */
+	inline bool PfCalcEstimate(Node &n)
+	{
+		if (!m_has_region_target) return Tbase::PfCalcEstimate(n);
+
+		static const int dg_dir_to_x_offs[] = {-1, 0, 1, 0};
+		static const int dg_dir_to_y_offs[] = {0, 1, 0, -1};
+		if (PfDetectDestination(n)) {
+			n.m_estimate = max(n.m_cost, n.m_parent->m_estimate);
+			return true;
+		}
+
+		TileIndex tile = n.GetTile();
+		DiagDirection exitdir = TrackdirToExitdir(n.GetTrackdir());
+		int x1 = 2 * TileX(tile) + dg_dir_to_x_offs[(int)exitdir];
+		int y1 = 2 * TileY(tile) + dg_dir_to_y_offs[(int)exitdir];
+		/* The region spans the (doubled) coordinates from 2 * first tile to 2 * last tile. */
+		const WaterRegionPatchDesc &target = m_corridor.back();
+		int x_min = 2 * target.x * WATER_REGION_EDGE_LENGTH;
+		int y_min = 2 * target.y * WATER_REGION_EDGE_LENGTH;
+		int x_max = x_min + 2 * (WATER_REGION_EDGE_LENGTH - 1);
+		int y_max = y_min + 2 * (WATER_REGION_EDGE_LENGTH - 1);
+		int dx = (x1 < x_min) ? x_min - x1 : (x1 > x_max) ? x1 - x_max : (x1 & 1);
+		int dy = (y1 < y_min) ? y_min - y1 : (y1 > y_max) ? y1 - y_max : (y1 & 1);
+		int dmin = min(dx, dy);
+		int dxy = abs(dx - dy);
+		int d = dmin * YAPF_TILE_CORNER_LENGTH + (dxy - 1) * (YAPF_TILE_LENGTH / 2);
+		/* The distance to a region is not consistent from tile to tile (e.g. when entering the region
+		 * diagonally), so never let the estimate drop below the one of the parent node. */
+		n.m_estimate = max(n.m_cost + d, n.m_parent->m_estimate);
+		return true;
+	}
+};
+
 /**
  * Config struct of YAPF for ships.
  *  Defines all 6 base YAPF modules as classes providing services for CYapfBaseT.
@@ -209,7 +364,7 @@ struct CYapfShip_TypesT
 	typedef CYapfBaseT<Types>                 PfBase;        // base pathfinder class
 	typedef CYapfFollowShipT<Types>           PfFollow;      // node follower
 	typedef CYapfOriginTileT<Types>           PfOrigin;      // origin provider
-	typedef CYapfDestinationTileT<Types>      PfDestination; // destination/distance provider
+	typedef CYapfDestinationTileWaterT<Types> PfDestination; // destination/distance provider
 	typedef CYapfSegmentCostCacheNoneT<Types> PfCache;       // segment cost cache provider
 	typedef CYapfCostShipT<Types>             PfCost;        // cost provider
 };
@@ -38,6 +38,7 @@
 #include "programmable_signals.h"
 #include "spritecache.h"
 #include "core/container_func.hpp"
+#include "pathfinder/water_regions.h"
 
 #include "table/strings.h"
 #include "table/railtypes.h"
@@ -718,6 +719,7 @@ CommandCost CmdRemoveSingleRail(TileIndex tile, DoCommandFlag flags, uint32 p1,
 					/* If there is flat water on the lower halftile, convert the tile to shore so the water remains */
 					if (GetRailGroundType(tile) == RAIL_GROUND_WATER && IsSlopeWithOneCornerRaised(tileh)) {
 						MakeShore(tile);
+						InvalidateWaterRegion(tile);
 					} else {
 						DoClearSquare(tile);
 					}
@@ -789,6 +791,7 @@ bool FloodHalftile(TileIndex t)
 			rail_bits = rail_bits & ~to_remove;
 			if (rail_bits == 0) {
 				MakeShore(t);
+				InvalidateWaterRegion(t);
 				MarkTileDirtyByTile(t);
 				return flooded;
 			}
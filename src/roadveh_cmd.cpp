@@ -38,6 +38,7 @@
 #include "zoom_func.h"
 #include "scope_info.h"
 #include "string_func.h"
+#include "tick_timing.h"
 
 #include "table/strings.h"
 
@@ -1653,6 +1654,8 @@ bool RoadVehicle::Tick()
 	this->tick_counter++;
 
 	if (this->IsFrontEngine()) {
+		TickTimer timer(TTP_ROAD_VEHICLES);
+
 		if (!(this->IsRoadVehicleStopped())) this->running_ticks++;
 		return RoadVehController(this);
 	}
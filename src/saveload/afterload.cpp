@@ -655,25 +655,25 @@ bool AfterLoadGame()
 
 		/* In old savegame versions, the heightlevel was coded in bits 0..3 of the type field */
 		for (TileIndex t = 0; t < map_size; t++) {
-			_m[t].height = GB(_m[t].type, 0, 4);
-			SB(_m[t].type, 0, 2, GB(_me[t].m6, 0, 2));
+			_mth[t].height = GB(_mth[t].type, 0, 4);
+			SB(_mth[t].type, 0, 2, GB(_me[t].m6, 0, 2));
 			SB(_me[t].m6, 0, 2, 0);
 			if (MayHaveBridgeAbove(t)) {
-				SB(_m[t].type, 2, 2, GB(_me[t].m6, 6, 2));
+				SB(_mth[t].type, 2, 2, GB(_me[t].m6, 6, 2));
 				SB(_me[t].m6, 6, 2, 0);
 			} else {
-				SB(_m[t].type, 2, 2, 0);
+				SB(_mth[t].type, 2, 2, 0);
 			}
 		}
 	} else if (SlXvIsFeaturePresent(XSLFI_HEIGHT_8_BIT)) {
 		for (TileIndex t = 0; t < map_size; t++) {
-			SB(_m[t].type, 0, 2, GB(_me[t].m6, 0, 2));
+			SB(_mth[t].type, 0, 2, GB(_me[t].m6, 0, 2));
 			SB(_me[t].m6, 0, 2, 0);
 			if (MayHaveBridgeAbove(t)) {
-				SB(_m[t].type, 2, 2, GB(_me[t].m6, 6, 2));
+				SB(_mth[t].type, 2, 2, GB(_me[t].m6, 6, 2));
 				SB(_me[t].m6, 6, 2, 0);
 			} else {
-				SB(_m[t].type, 2, 2, 0);
+				SB(_mth[t].type, 2, 2, 0);
 			}
 		}
 	}
@@ -3228,15 +3228,13 @@ bool AfterLoadGame()
 	 * saved-by-server savegame. There are no clients with a backup, so clear it.
 	 * Furthermore before savegame version 192 the actual content was always corrupt.
 	 */
-	if (!_networking || _network_server || IsSavegameVersionBefore(192)) {
-#ifndef DEBUG_DUMP_COMMANDS
+	if ((!_networking || _network_server || IsSavegameVersionBefore(192)) && !_network_replaying) {
 		/* Note: We cannot use CleanPool since that skips part of the destructor
 		 * and then leaks un-reachable Orders in the order pool. */
 		OrderBackup *ob;
 		FOR_ALL_ORDER_BACKUPS(ob) {
 			delete ob;
 		}
-#endif
 	}
 
 	if (SlXvIsFeatureMissing(XSLFI_TIMETABLES_START_TICKS)) {
@@ -79,6 +79,8 @@ const SlxiSubChunkInfo _sl_xv_sub_chunk_infos[] = {
 	{ XSLFI_SCHEDULED_DISPATCH,     XSCF_NULL,                1,   1, "scheduled_dispatch",        NULL, NULL, NULL        },
 	{ XSLFI_MORE_TOWN_GROWTH_RATES, XSCF_NULL,                1,   1, "more_town_growth_rates",    NULL, NULL, NULL        },
 	{ XSLFI_MULTIPLE_DOCKS,         XSCF_NULL,                1,   1, "multiple_docks",            NULL, NULL, "DOCK"      },
+	{ XSLFI_LINKGRAPH_INCREMENTAL,  XSCF_NULL,                1,   1, "linkgraph_incremental",     NULL, NULL, NULL        },
+	{ XSLFI_WHOLE_MAP_CHUNK,        XSCF_NULL,                1,   1, "whole_map_chunk",           NULL, NULL, "WMAP"      },
 	{ XSLFI_NULL, XSCF_NULL, 0, 0, NULL, NULL, NULL, NULL },// This is the end marker
 };
 
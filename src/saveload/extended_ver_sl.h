@@ -53,6 +53,8 @@ enum SlXvFeatureIndex {
 	XSLFI_SCHEDULED_DISPATCH,                     ///< Scheduled vehicle dispatching
 	XSLFI_MORE_TOWN_GROWTH_RATES,                 ///< More town growth rates
 	XSLFI_MULTIPLE_DOCKS,                         ///< Multiple docks
+	XSLFI_LINKGRAPH_INCREMENTAL,                  ///< Link graph input signatures for skipping unchanged recalculations
+	XSLFI_WHOLE_MAP_CHUNK,                        ///< Whole map saved in a single chunk
 
 	XSLFI_RIFF_HEADER_60_BIT,                     ///< Size field in RIFF chunk header is 60 bit
 	XSLFI_HEIGHT_8_BIT,                           ///< Map tile height is 8 bit instead of 4 bit, but savegame version may be before this became true in trunk
@@ -35,6 +35,7 @@ const SaveLoad *GetLinkGraphDesc()
 		 SLE_VAR(LinkGraph, last_compression, SLE_INT32),
 		SLEG_VAR(_num_nodes,                  SLE_UINT16),
 		 SLE_VAR(LinkGraph, cargo,            SLE_UINT8),
+		 SLE_CONDVAR_X(LinkGraph, last_job_signature, SLE_UINT64, 0, SL_MAX_VERSION, SlXvFeatureTest(XSLFTO_AND, XSLFI_LINKGRAPH_INCREMENTAL)),
 		 SLE_END()
 	};
 	return link_graph_desc;
@@ -162,6 +163,37 @@ void SaveLoad_LinkGraph(LinkGraph &lg)
 	}
 }
 
+/**
+ * Save the link graph of a link graph job. The job keeps the edges in a
+ * compressed array instead of the edge matrix; they are saved in the same
+ * format as by SaveLoad_LinkGraph.
+ * @param lgj Link graph job whose link graph is to be saved.
+ */
+void Save_LinkGraphJobGraph(LinkGraphJob &lgj)
+{
+	LinkGraph &lg = lgj.link_graph;
+	uint size = lg.Size();
+	for (NodeID from = 0; from < size; ++from) {
+		SlObject(&lg.nodes[from], _node_desc);
+		uint first = lgj.edge_offsets[from];
+		uint last = lgj.edge_offsets[from + 1];
+
+		/* The edge from the node to itself just holds the start of the edge list. */
+		Edge start;
+		start.capacity = 0;
+		start.usage = 0;
+		start.last_unrestricted_update = INVALID_DATE;
+		start.last_restricted_update = INVALID_DATE;
+		start.next_edge = first != last ? lgj.edges[first].to : INVALID_NODE;
+		SlObject(&start, _edge_desc);
+
+		/* The copied edges still have their next_edge members from the link graph. */
+		for (uint i = first; i != last; ++i) {
+			SlObject(&lgj.edges[i].base, _edge_desc);
+		}
+	}
+}
+
 /**
  * Save a link graph job.
  * @param lgj LinkGraphJob to be saved.
@@ -171,7 +203,7 @@ static void DoSave_LGRJ(LinkGraphJob *lgj)
 	SlObject(lgj, GetLinkGraphJobDesc());
 	_num_nodes = lgj->Size();
 	SlObject(const_cast<LinkGraph *>(&lgj->Graph()), GetLinkGraphDesc());
-	SaveLoad_LinkGraph(const_cast<LinkGraph &>(lgj->Graph()));
+	Save_LinkGraphJobGraph(*lgj);
 }
 
 /**
@@ -257,6 +289,12 @@ void AfterLoadLinkGraphs()
 		}
 	}
 
+	/* Jobs are loaded with a full edge matrix; move the edges into the jobs' compressed edge arrays. */
+	LinkGraphJob *lgj;
+	FOR_ALL_LINK_GRAPH_JOBS(lgj) {
+		lgj->CompressEdgesAfterLoad();
+	}
+
 	LinkGraphSchedule::instance.SpawnAll();
 }
 
@@ -15,6 +15,7 @@
 #include "../fios.h"
 
 #include "saveload.h"
+#include "extended_ver_sl.h"
 
 #include "../safeguards.h"
 
@@ -59,19 +60,7 @@ static void Load_MAPT()
 
 	for (TileIndex i = 0; i != size;) {
 		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].type = buf[j];
-	}
-}
-
-static void Save_MAPT()
-{
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].type;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
+		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _mth[i++].type = buf[j];
 	}
 }
 
@@ -82,19 +71,7 @@ static void Load_MAPH()
 
 	for (TileIndex i = 0; i != size;) {
 		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i++].height = buf[j];
-	}
-}
-
-static void Save_MAPH()
-{
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].height;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
+		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _mth[i++].height = buf[j];
 	}
 }
 
@@ -109,18 +86,6 @@ static void Load_MAP1()
 	}
 }
 
-static void Save_MAP1()
-{
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m1;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
-}
-
 static void Load_MAP2()
 {
 	SmallStackSafeStackAlloc<uint16, MAP_SL_BUF_SIZE> buf;
@@ -135,18 +100,6 @@ static void Load_MAP2()
 	}
 }
 
-static void Save_MAP2()
-{
-	SmallStackSafeStackAlloc<uint16, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size * sizeof(uint16));
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m2;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT16);
-	}
-}
-
 static void Load_MAP3()
 {
 	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
@@ -158,18 +111,6 @@ static void Load_MAP3()
 	}
 }
 
-static void Save_MAP3()
-{
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m3;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
-}
-
 static void Load_MAP4()
 {
 	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
@@ -181,18 +122,6 @@ static void Load_MAP4()
 	}
 }
 
-static void Save_MAP4()
-{
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m4;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
-}
-
 static void Load_MAP5()
 {
 	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
@@ -204,18 +133,6 @@ static void Load_MAP5()
 	}
 }
 
-static void Save_MAP5()
-{
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
-	TileIndex size = MapSize();
-
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _m[i++].m5;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-	}
-}
-
 static void Load_MAP6()
 {
 	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
@@ -240,50 +157,117 @@ static void Load_MAP6()
 	}
 }
 
-static void Save_MAP6()
+static void Load_MAP7()
 {
 	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
 	TileIndex size = MapSize();
 
-	SlSetLength(size);
 	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _me[i++].m6;
 		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
+		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _me[i++].m7 = buf[j];
 	}
 }
 
-static void Load_MAP7()
+/**
+ * Save or load one byte wide field of all tiles as a contiguous plane.
+ * @param save Whether to save (true) or load (false) the plane.
+ * @param tiles The map array the field is part of.
+ * @param field The field to save or load.
+ */
+template <typename Ttile>
+static void SaveLoadMapPlane8(bool save, Ttile *tiles, byte Ttile::*field)
 {
 	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
 	TileIndex size = MapSize();
 
-	for (TileIndex i = 0; i != size;) {
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _me[i++].m7 = buf[j];
+	for (TileIndex i = 0; i != size; i += MAP_SL_BUF_SIZE) {
+		if (save) {
+			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = tiles[i + j].*field;
+			SlCopyBytes(buf, MAP_SL_BUF_SIZE);
+		} else {
+			SlCopyBytes(buf, MAP_SL_BUF_SIZE);
+			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) tiles[i + j].*field = buf[j];
+		}
 	}
 }
 
-static void Save_MAP7()
+/**
+ * Save or load the m2 field of all tiles as a contiguous plane of little endian 16 bit values.
+ * @param save Whether to save (true) or load (false) the plane.
+ */
+static void SaveLoadMapPlaneM2(bool save)
 {
-	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE> buf;
+	SmallStackSafeStackAlloc<byte, MAP_SL_BUF_SIZE * 2> buf;
 	TileIndex size = MapSize();
 
-	SlSetLength(size);
-	for (TileIndex i = 0; i != size;) {
-		for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) buf[j] = _me[i++].m7;
-		SlArray(buf, MAP_SL_BUF_SIZE, SLE_UINT8);
+	for (TileIndex i = 0; i != size; i += MAP_SL_BUF_SIZE) {
+		if (save) {
+			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) {
+				buf[j * 2]     = GB(_m[i + j].m2, 0, 8);
+				buf[j * 2 + 1] = GB(_m[i + j].m2, 8, 8);
+			}
+			SlCopyBytes(buf, MAP_SL_BUF_SIZE * 2);
+		} else {
+			SlCopyBytes(buf, MAP_SL_BUF_SIZE * 2);
+			for (uint j = 0; j != MAP_SL_BUF_SIZE; j++) _m[i + j].m2 = buf[j * 2] | (buf[j * 2 + 1] << 8);
+		}
 	}
 }
 
+/**
+ * Save or load the whole map in one chunk.
+ * The chunk holds one contiguous plane per tile field, in this order: type, height,
+ * m1, m2, m3, m4, m5, m6 and m7. All planes are one byte per tile, except m2, which
+ * is two bytes per tile in little endian order. The format thus does not depend on the
+ * layout of the map arrays in memory, nor on the byte order of the machine.
+ * @param save Whether to save (true) or load (false) the map.
+ */
+static void SaveLoadWholeMap(bool save)
+{
+	static const size_t BYTES_PER_TILE = 10;
+
+	TileIndex size = MapSize();
+	if (save) {
+		SlSetLength((size_t)size * BYTES_PER_TILE);
+	} else if (SlGetFieldLength() != (size_t)size * BYTES_PER_TILE) {
+		SlErrorCorrupt("Invalid length of whole map chunk");
+	}
+
+	SaveLoadMapPlane8(save, _mth, &TileTypeHeight::type);
+	SaveLoadMapPlane8(save, _mth, &TileTypeHeight::height);
+	SaveLoadMapPlane8(save, _m, &Tile::m1);
+	SaveLoadMapPlaneM2(save);
+	SaveLoadMapPlane8(save, _m, &Tile::m3);
+	SaveLoadMapPlane8(save, _m, &Tile::m4);
+	SaveLoadMapPlane8(save, _m, &Tile::m5);
+	SaveLoadMapPlane8(save, _me, &TileExtended::m6);
+	SaveLoadMapPlane8(save, _me, &TileExtended::m7);
+}
+
+static void Save_WMAP()
+{
+	SaveLoadWholeMap(true);
+}
+
+static void Load_WMAP()
+{
+	SaveLoadWholeMap(false);
+}
+
+/*
+ * The per field map chunks are only loaded for savegames from before the whole map chunk;
+ * the map is always saved using the whole map chunk.
+ */
 extern const ChunkHandler _map_chunk_handlers[] = {
 	{ 'MAPS', Save_MAPS, Load_MAPS, NULL, Check_MAPS, CH_RIFF },
-	{ 'MAPT', Save_MAPT, Load_MAPT, NULL, NULL,       CH_RIFF },
-	{ 'MAPH', Save_MAPH, Load_MAPH, NULL, NULL,       CH_RIFF },
-	{ 'MAPO', Save_MAP1, Load_MAP1, NULL, NULL,       CH_RIFF },
-	{ 'MAP2', Save_MAP2, Load_MAP2, NULL, NULL,       CH_RIFF },
-	{ 'M3LO', Save_MAP3, Load_MAP3, NULL, NULL,       CH_RIFF },
-	{ 'M3HI', Save_MAP4, Load_MAP4, NULL, NULL,       CH_RIFF },
-	{ 'MAP5', Save_MAP5, Load_MAP5, NULL, NULL,       CH_RIFF },
-	{ 'MAPE', Save_MAP6, Load_MAP6, NULL, NULL,       CH_RIFF },
-	{ 'MAP7', Save_MAP7, Load_MAP7, NULL, NULL,       CH_RIFF | CH_LAST },
+	{ 'WMAP', Save_WMAP, Load_WMAP, NULL, NULL,       CH_RIFF },
+	{ 'MAPT', NULL,      Load_MAPT, NULL, NULL,       CH_RIFF },
+	{ 'MAPH', NULL,      Load_MAPH, NULL, NULL,       CH_RIFF },
+	{ 'MAPO', NULL,      Load_MAP1, NULL, NULL,       CH_RIFF },
+	{ 'MAP2', NULL,      Load_MAP2, NULL, NULL,       CH_RIFF },
+	{ 'M3LO', NULL,      Load_MAP3, NULL, NULL,       CH_RIFF },
+	{ 'M3HI', NULL,      Load_MAP4, NULL, NULL,       CH_RIFF },
+	{ 'MAP5', NULL,      Load_MAP5, NULL, NULL,       CH_RIFF },
+	{ 'MAPE', NULL,      Load_MAP6, NULL, NULL,       CH_RIFF },
+	{ 'MAP7', NULL,      Load_MAP7, NULL, NULL,       CH_RIFF | CH_LAST },
 };
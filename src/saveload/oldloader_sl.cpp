@@ -47,6 +47,7 @@ void FixOldMapArray()
 {
 	/* TTO/TTD/TTDP savegames could have buoys at tile 0
 	 * (without assigned station struct) */
+	MemSetT(&_mth[0], 0);
 	MemSetT(&_m[0], 0);
 	SetTileType(0, MP_WATER);
 	SetTileOwner(0, OWNER_WATER);
@@ -1510,7 +1511,7 @@ static bool LoadOldMapPart2(LoadgameState *ls, int num)
 	uint i;
 
 	for (i = 0; i < OLD_MAP_SIZE; i++) {
-		_m[i].type = ReadByte(ls);
+		_mth[i].type = ReadByte(ls);
 	}
 	for (i = 0; i < OLD_MAP_SIZE; i++) {
 		_m[i].m5 = ReadByte(ls);
@@ -25,7 +25,7 @@
 #include "../debug.h"
 #include "../station_base.h"
 #include "../dock_base.h"
-#include "../thread/thread.h"
+#include "../thread/thread_pool.h"
 #include "../town.h"
 #include "../network/network.h"
 #include "../window_func.h"
@@ -54,9 +54,18 @@
 #include "saveload_filter.h"
 #include "extended_ver_sl.h"
 
+#if defined(UNIX) && !defined(__MORPHOS__)
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/wait.h>
+#include <string>
+#endif
+
 #include "../safeguards.h"
 
 #include <deque>
+#include <memory>
 #include <vector>
 
 /*
@@ -335,6 +344,31 @@ struct ReadBuffer {
 		return *this->bufp++;
 	}
 
+	/**
+	 * Read a number of bytes at once.
+	 * @param ptr The buffer to read into.
+	 * @param length The number of bytes to read.
+	 */
+	void CopyBytes(byte *ptr, size_t length)
+	{
+		while (length != 0) {
+			if (this->bufp == this->bufe) {
+				size_t len = this->reader->Read(this->buf, lengthof(this->buf));
+				if (len == 0) SlErrorCorrupt("Unexpected end of chunk");
+
+				this->read += len;
+				this->bufp = this->buf;
+				this->bufe = this->buf + len;
+			}
+
+			size_t to_copy = min<size_t>(length, this->bufe - this->bufp);
+			memcpy(ptr, this->bufp, to_copy);
+			this->bufp += to_copy;
+			ptr += to_copy;
+			length -= to_copy;
+		}
+	}
+
 	/**
 	 * Get the size of the memory dump made so far.
 	 * @return The size.
@@ -373,6 +407,28 @@ struct MemoryDumper {
 		*this->buf++ = b;
 	}
 
+	/**
+	 * Write a number of bytes at once into the dumper.
+	 * @param ptr The bytes to write.
+	 * @param length The number of bytes to write.
+	 */
+	void CopyBytes(const byte *ptr, size_t length)
+	{
+		while (length != 0) {
+			if (this->buf == this->bufe) {
+				this->buf = CallocT<byte>(MEMORY_CHUNK_SIZE);
+				*this->blocks.Append() = this->buf;
+				this->bufe = this->buf + MEMORY_CHUNK_SIZE;
+			}
+
+			size_t to_copy = min<size_t>(length, this->bufe - this->buf);
+			memcpy(this->buf, ptr, to_copy);
+			this->buf += to_copy;
+			ptr += to_copy;
+			length -= to_copy;
+		}
+	}
+
 	/**
 	 * Flush this dumper into a writer.
 	 * @param writer The filter we want to use.
@@ -622,7 +678,11 @@ void NORETURN CDECL SlErrorCorruptFmt(const char *msg, ...)
 
 typedef void (*AsyncSaveFinishProc)();                ///< Callback for when the savegame loading is finished.
 static AsyncSaveFinishProc _async_save_finish = NULL; ///< Callback to call when the savegame loading is finished.
-static ThreadObject *_save_thread;                    ///< The thread we're using to compress and write a savegame
+static ThreadPoolHandle _save_task;                   ///< The thread pool task we're using to compress and write a savegame
+
+#if defined(UNIX) && !defined(__MORPHOS__)
+static void CheckForkedSave(bool wait);
+#endif
 
 /**
  * Called by save thread to tell we finished saving.
@@ -641,16 +701,19 @@ static void SetAsyncSaveFinish(AsyncSaveFinishProc proc)
  */
 void ProcessAsyncSaveFinish()
 {
+#if defined(UNIX) && !defined(__MORPHOS__)
+	CheckForkedSave(false);
+#endif
+
 	if (_async_save_finish == NULL) return;
 
 	_async_save_finish();
 
 	_async_save_finish = NULL;
 
-	if (_save_thread != NULL) {
-		_save_thread->Join();
-		delete _save_thread;
-		_save_thread = NULL;
+	if (_save_task) {
+		_save_task->Join();
+		_save_task.reset();
 	}
 }
 
@@ -954,17 +1017,17 @@ void SlSetLength(size_t length)
  * @param ptr The source or destination of the object being manipulated
  * @param length number of bytes this fast CopyBytes lasts
  */
-static void SlCopyBytes(void *ptr, size_t length)
+void SlCopyBytes(void *ptr, size_t length)
 {
 	byte *p = (byte *)ptr;
 
 	switch (_sl.action) {
 		case SLA_LOAD_CHECK:
 		case SLA_LOAD:
-			for (; length != 0; length--) *p++ = SlReadByte();
+			_sl.reader->CopyBytes(p, length);
 			break;
 		case SLA_SAVE:
-			for (; length != 0; length--) SlWriteByte(*p++);
+			_sl.dumper->CopyBytes(p, length);
 			break;
 		default: NOT_REACHED();
 	}
@@ -2450,6 +2513,266 @@ struct ZlibSaveFilter : SaveFilter {
 	}
 };
 
+
+/** Amount of uncompressed data in each block of the parallel zlib format. */
+static const size_t PARALLEL_ZLIB_BLOCK_SIZE = 1024 * 1024;
+
+/**
+ * A block of the parallel zlib format, compressed or decompressed by a thread pool task.
+ * On disk each block is stored as its uncompressed and compressed size (both 32 bits, big endian), followed by
+ * the zlib stream of the block. The last block is followed by a terminator with an uncompressed size of zero and the
+ * number of blocks, and a seek index with the offset of each block header in the compressed stream (64 bits, big endian).
+ */
+struct ParallelZlibBlock {
+	std::vector<byte> input;  ///< Data to compress or decompress.
+	std::vector<byte> output; ///< Compressed or decompressed data.
+	size_t raw_size;          ///< Size of the uncompressed data.
+	bool ok;                  ///< Whether zlib succeeded.
+	ThreadPoolHandle task;    ///< Task working on the block, if any.
+
+	/**
+	 * Compress the input of the block.
+	 * @param compression_level The requested level of compression.
+	 */
+	void Compress(byte compression_level)
+	{
+		uLongf size = compressBound((uLong)this->input.size());
+		this->output.resize(size);
+		this->ok = compress2(this->output.data(), &size, this->input.data(), (uLong)this->input.size(), compression_level) == Z_OK;
+		this->output.resize(size);
+	}
+
+	/** Decompress the input of the block. */
+	void Decompress()
+	{
+		uLongf size = (uLongf)this->raw_size;
+		this->output.resize(this->raw_size);
+		this->ok = uncompress(this->output.data(), &size, this->input.data(), (uLong)this->input.size()) == Z_OK && size == this->raw_size;
+	}
+
+	/** Wait for the task working on the block to finish. */
+	void Join()
+	{
+		if (this->task) this->task->Join();
+		this->task.reset();
+	}
+};
+
+/**
+ * Get the maximum number of blocks which are compressed or decompressed at the same time.
+ * @return The number of blocks.
+ */
+static size_t GetParallelZlibBlocksInFlight()
+{
+	return max<size_t>(2, ThreadPool::GetWorkerCount() * 2);
+}
+
+/** Filter using zlib compression of independent blocks in the thread pool. */
+struct ParallelZlibLoadFilter : LoadFilter {
+	std::deque<std::unique_ptr<ParallelZlibBlock>> blocks; ///< Blocks read ahead, in file order.
+	std::vector<byte> current;                             ///< Decompressed data of the block being read.
+	size_t current_pos;                                    ///< Position in #current.
+	bool end_reached;                                      ///< Whether the terminator of the blocks has been read.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain The next filter in this chain.
+	 */
+	ParallelZlibLoadFilter(LoadFilter *chain) : LoadFilter(chain), current_pos(0), end_reached(false)
+	{
+	}
+
+	/** Clean everything up. */
+	~ParallelZlibLoadFilter()
+	{
+		this->JoinAll();
+	}
+
+	/** Wait for all tasks, so no block is freed while a task still works on it. */
+	void JoinAll()
+	{
+		for (auto &block : this->blocks) block->Join();
+	}
+
+	/**
+	 * Read exactly the given number of bytes from the next filter.
+	 * @param buf The bytes to read.
+	 * @param size The number of bytes to read.
+	 */
+	void ReadFromChain(byte *buf, size_t size)
+	{
+		while (size != 0) {
+			size_t read = this->chain->Read(buf, size);
+			if (read == 0) SlError(STR_GAME_SAVELOAD_ERROR_FILE_NOT_READABLE, "unexpected end of parallel zlib stream");
+			buf += read;
+			size -= read;
+		}
+	}
+
+	/** Read blocks from the file and queue their decompression, until enough are in flight. */
+	void ReadAhead()
+	{
+		while (!this->end_reached && this->blocks.size() < GetParallelZlibBlocksInFlight()) {
+			byte header[8];
+			this->ReadFromChain(header, sizeof(header));
+			const uint32 raw_size = FROM_BE32(*(uint32 *)header);
+			const uint32 compressed_size = FROM_BE32(*(uint32 *)(header + 4));
+			if (raw_size == 0) {
+				/* The terminator; the seek index after it is not needed for reading the stream. */
+				this->end_reached = true;
+				break;
+			}
+			if (raw_size > PARALLEL_ZLIB_BLOCK_SIZE || compressed_size > compressBound(PARALLEL_ZLIB_BLOCK_SIZE)) {
+				SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_SAVEGAME, "invalid parallel zlib block");
+			}
+
+			std::unique_ptr<ParallelZlibBlock> block(new ParallelZlibBlock());
+			block->raw_size = raw_size;
+			block->input.resize(compressed_size);
+			this->ReadFromChain(block->input.data(), compressed_size);
+
+			ParallelZlibBlock *b = block.get();
+			if (!ThreadPool::Submit([b]() { b->Decompress(); }, &b->task)) b->Decompress();
+			this->blocks.push_back(std::move(block));
+		}
+	}
+
+	/* virtual */ size_t Read(byte *buf, size_t size)
+	{
+		size_t done = 0;
+		while (done < size) {
+			if (this->current_pos == this->current.size()) {
+				this->ReadAhead();
+				if (this->blocks.empty()) break;
+
+				ParallelZlibBlock *block = this->blocks.front().get();
+				block->Join();
+				if (!block->ok) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "uncompress() failed");
+				this->current.swap(block->output);
+				this->current_pos = 0;
+				this->blocks.pop_front();
+
+				/* Keep the workers busy while this block is handed out. */
+				this->ReadAhead();
+			}
+
+			size_t n = min(size - done, this->current.size() - this->current_pos);
+			memcpy(buf + done, this->current.data() + this->current_pos, n);
+			this->current_pos += n;
+			done += n;
+		}
+		return done;
+	}
+
+	/* virtual */ void Reset()
+	{
+		this->JoinAll();
+		this->blocks.clear();
+		this->current.clear();
+		this->current_pos = 0;
+		this->end_reached = false;
+		this->chain->Reset();
+	}
+};
+
+/** Filter using zlib compression of independent blocks in the thread pool. */
+struct ParallelZlibSaveFilter : SaveFilter {
+	byte compression_level;                                ///< The requested level of compression.
+	std::vector<byte> pending;                             ///< Data not yet handed out in a block.
+	std::deque<std::unique_ptr<ParallelZlibBlock>> blocks; ///< Blocks being compressed, in file order.
+	std::vector<uint64> index;                             ///< Offset of each written block in the compressed stream.
+	uint64 written;                                        ///< Number of bytes of compressed stream written so far.
+
+	/**
+	 * Initialise this filter.
+	 * @param chain             The next filter in this chain.
+	 * @param compression_level The requested level of compression.
+	 */
+	ParallelZlibSaveFilter(SaveFilter *chain, byte compression_level) : SaveFilter(chain), compression_level(compression_level), written(0)
+	{
+		this->pending.reserve(PARALLEL_ZLIB_BLOCK_SIZE);
+	}
+
+	/** Clean up what we allocated. */
+	~ParallelZlibSaveFilter()
+	{
+		for (auto &block : this->blocks) block->Join();
+	}
+
+	/**
+	 * Write bytes to the next filter, keeping track of the stream offset.
+	 * @param buf The bytes to write.
+	 * @param size The number of bytes to write.
+	 */
+	void WriteToChain(byte *buf, size_t size)
+	{
+		this->chain->Write(buf, size);
+		this->written += size;
+	}
+
+	/**
+	 * Write two 32 bits big endian values to the next filter.
+	 * @param a The first value.
+	 * @param b The second value.
+	 */
+	void WritePair(uint32 a, uint32 b)
+	{
+		uint32 header[2] = { TO_BE32(a), TO_BE32(b) };
+		this->WriteToChain((byte *)header, sizeof(header));
+	}
+
+	/** Queue the compression of the pending data. */
+	void SubmitBlock()
+	{
+		std::unique_ptr<ParallelZlibBlock> block(new ParallelZlibBlock());
+		block->input.swap(this->pending);
+		block->raw_size = block->input.size();
+		this->pending.reserve(PARALLEL_ZLIB_BLOCK_SIZE);
+
+		ParallelZlibBlock *b = block.get();
+		const byte level = this->compression_level;
+		if (!ThreadPool::Submit([b, level]() { b->Compress(level); }, &b->task)) b->Compress(level);
+		this->blocks.push_back(std::move(block));
+
+		while (this->blocks.size() > GetParallelZlibBlocksInFlight()) this->WriteFrontBlock();
+	}
+
+	/** Wait for the oldest block to be compressed and write it. */
+	void WriteFrontBlock()
+	{
+		ParallelZlibBlock *block = this->blocks.front().get();
+		block->Join();
+		if (!block->ok) SlError(STR_GAME_SAVELOAD_ERROR_BROKEN_INTERNAL_ERROR, "zlib returned error code");
+
+		this->index.push_back(this->written);
+		this->WritePair((uint32)block->raw_size, (uint32)block->output.size());
+		this->WriteToChain(block->output.data(), block->output.size());
+		this->blocks.pop_front();
+	}
+
+	/* virtual */ void Write(byte *buf, size_t size)
+	{
+		while (size != 0) {
+			size_t n = min(size, PARALLEL_ZLIB_BLOCK_SIZE - this->pending.size());
+			this->pending.insert(this->pending.end(), buf, buf + n);
+			buf += n;
+			size -= n;
+			if (this->pending.size() == PARALLEL_ZLIB_BLOCK_SIZE) this->SubmitBlock();
+		}
+	}
+
+	/* virtual */ void Finish()
+	{
+		if (!this->pending.empty()) this->SubmitBlock();
+		while (!this->blocks.empty()) this->WriteFrontBlock();
+
+		/* Terminator, followed by the seek index. */
+		this->WritePair(0, (uint32)this->index.size());
+		for (uint64 offset : this->index) this->WritePair((uint32)(offset >> 32), (uint32)offset);
+		this->chain->Finish();
+	}
+};
+
 #endif /* WITH_ZLIB */
 
 /********************************************
@@ -2598,6 +2921,13 @@ static const SaveLoadFormat _saveload_formats[] = {
 #endif
 	/* Roughly 5 times larger at only 1% of the CPU usage over zlib level 6. */
 	{"none",   TO_BE32X('OTTN'), CreateLoadFilter<NoCompLoadFilter>, CreateSaveFilter<NoCompSaveFilter>, 0, 0, 0},
+#if defined(WITH_ZLIB)
+	/* Same compression as zlib, but in independent 1 MiB blocks which are compressed and decompressed in parallel.
+	 * Slightly larger than zlib as the blocks do not share a dictionary; listed before zlib so it is never picked by default. */
+	{"zlib_mt", TO_BE32X('OTTP'), CreateLoadFilter<ParallelZlibLoadFilter>, CreateSaveFilter<ParallelZlibSaveFilter>, 0, 6, 9},
+#else
+	{"zlib_mt", TO_BE32X('OTTP'), NULL,                               NULL,                               0, 0, 0},
+#endif
 #if defined(WITH_ZLIB)
 	/* After level 6 the speed reduction is significant (1.5x to 2.5x slower per level), but the reduction in filesize is
 	 * fairly insignificant (~1% for each step). Lower levels become ~5-10% bigger by each level than level 6 while level
@@ -2745,6 +3075,23 @@ static void SaveFileError()
 	SaveFileDone();
 }
 
+/**
+ * Write the header and the game, which has already been written into memory,
+ * through the selected compressor to the save filter.
+ */
+static void WriteMemorySavegame()
+{
+	byte compression;
+	const SaveLoadFormat *fmt = GetSavegameFormat(_savegame_format, &compression);
+
+	/* We have written our stuff to memory, now write it to file! */
+	uint32 hdr[2] = { fmt->tag, TO_BE32((SAVEGAME_VERSION | SAVEGAME_VERSION_EXT) << 16) };
+	_sl.sf->Write((byte*)hdr, sizeof(hdr));
+
+	_sl.sf = fmt->init_write(_sl.sf, compression);
+	_sl.dumper->Flush(_sl.sf);
+}
+
 /**
  * We have written the whole game into memory, _memory_savegame, now find
  * and appropriate compressor and start writing to file.
@@ -2752,15 +3099,7 @@ static void SaveFileError()
 static SaveOrLoadResult SaveFileToDisk(bool threaded)
 {
 	try {
-		byte compression;
-		const SaveLoadFormat *fmt = GetSavegameFormat(_savegame_format, &compression);
-
-		/* We have written our stuff to memory, now write it to file! */
-		uint32 hdr[2] = { fmt->tag, TO_BE32((SAVEGAME_VERSION | SAVEGAME_VERSION_EXT) << 16) };
-		_sl.sf->Write((byte*)hdr, sizeof(hdr));
-
-		_sl.sf = fmt->init_write(_sl.sf, compression);
-		_sl.dumper->Flush(_sl.sf);
+		WriteMemorySavegame();
 
 		ClearSaveLoadState();
 
@@ -2795,18 +3134,172 @@ static void SaveFileToDiskThread(void *arg)
 	SaveFileToDisk(true);
 }
 
+#if defined(UNIX) && !defined(__MORPHOS__)
+static pid_t _fork_save_pid = -1;     ///< Process writing an autosave in the background, or -1 if there is none.
+static int _fork_save_fd = -1;        ///< Read end of the pipe the background save process reports its result on.
+static std::string _fork_save_result; ///< What has been read from the pipe so far: a #SaveOrLoadResult byte followed by the error message, if any.
+
+/**
+ * Save the game in a child process created by fork().
+ * The child has a copy-on-write snapshot of the game state, so it can serialise and
+ * compress the game while the parent keeps running. It never returns.
+ * @param fh The file to write the savegame to.
+ * @param fd The pipe to report the result on.
+ */
+static void ForkedSaveChild(FILE *fh, int fd)
+{
+	/* Only this thread exists in the child. */
+	ThreadPool::ForgetWorkersAfterFork();
+
+	std::string result(1, (char)SL_OK);
+	try {
+		_sl.action = SLA_SAVE;
+		_sl.dumper = new MemoryDumper();
+		_sl.sf = new FileWriter(fh);
+
+		_sl_version = SAVEGAME_VERSION;
+		SlXvSetCurrentState();
+
+		SaveViewportBeforeSaveGame();
+		SlSaveChunks();
+		WriteMemorySavegame();
+
+		ClearSaveLoadState();
+	} catch (...) {
+		ClearSaveLoadState();
+
+		result[0] = (char)SL_ERROR;
+		result += GetSaveLoadErrorString();
+	}
+
+	const char *p = result.c_str();
+	size_t left = result.size();
+	while (left > 0) {
+		ssize_t written = write(fd, p, left);
+		if (written < 0 && errno == EINTR) continue;
+		if (written <= 0) break;
+		p += written;
+		left -= written;
+	}
+	close(fd);
+
+	/* Do not run any exit handlers or destructors, those belong to the parent. */
+	_exit(result[0] == (char)SL_OK ? 0 : 1);
+}
+
+/**
+ * Start saving the game in a forked background process.
+ * @param fh The file to write the savegame to; it is closed in this process.
+ * @return True if the child process has been started, false if the game has to be saved the normal way.
+ */
+static bool DoForkedSave(FILE *fh)
+{
+	assert(!_sl.saveinprogress && _fork_save_pid == -1);
+
+	int fds[2];
+	if (pipe(fds) != 0) {
+		DEBUG(sl, 1, "Cannot create pipe for background save: %s", strerror(errno));
+		return false;
+	}
+
+	pid_t pid = fork();
+	if (pid < 0) {
+		DEBUG(sl, 1, "Cannot fork for background save: %s", strerror(errno));
+		close(fds[0]);
+		close(fds[1]);
+		return false;
+	}
+	if (pid == 0) {
+		close(fds[0]);
+		ForkedSaveChild(fh, fds[1]);
+		NOT_REACHED();
+	}
+
+	close(fds[1]);
+	fclose(fh);
+	fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+
+	_fork_save_pid = pid;
+	_fork_save_fd = fds[0];
+	_fork_save_result.clear();
+
+	/* Unlike SaveFileStart, do not stop fast-forwarding or show the busy cursor; the game keeps running. */
+	_sl.saveinprogress = true;
+	InvalidateWindowData(WC_STATUS_BAR, 0, SBI_SAVELOAD_START);
+	DEBUG(sl, 2, "Saving in background process %d", (int)pid);
+	return true;
+}
+
+/**
+ * Check whether the background save process has finished, and report its result.
+ * @param wait Whether to wait for the process to finish.
+ */
+static void CheckForkedSave(bool wait)
+{
+	if (_fork_save_pid == -1) return;
+
+	if (wait) fcntl(_fork_save_fd, F_SETFL, fcntl(_fork_save_fd, F_GETFL) & ~O_NONBLOCK);
+
+	char buf[256];
+	for (;;) {
+		ssize_t len = read(_fork_save_fd, buf, sizeof(buf));
+		if (len > 0) {
+			_fork_save_result.append(buf, len);
+			continue;
+		}
+		if (len < 0 && errno == EINTR) continue;
+		if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return; // Still busy.
+		break; // The child closed its end of the pipe.
+	}
+
+	close(_fork_save_fd);
+	int status = 0;
+	while (waitpid(_fork_save_pid, &status, 0) < 0 && errno == EINTR) {}
+	_fork_save_pid = -1;
+	_fork_save_fd = -1;
+
+	_sl.saveinprogress = false;
+	InvalidateWindowData(WC_STATUS_BAR, 0, SBI_SAVELOAD_FINISH);
+
+	if (WIFEXITED(status) && WEXITSTATUS(status) == 0 && !_fork_save_result.empty() && _fork_save_result[0] == (char)SL_OK) return;
+
+	if (_fork_save_result.size() > 1) {
+		/* Skip the result byte and the "colour" character */
+		DEBUG(sl, 0, "Background save failed: %s", _fork_save_result.c_str() + 4);
+		SetDParamStr(0, _fork_save_result.c_str() + 1);
+		ShowErrorMessage(STR_ERROR_AUTOSAVE_FAILED, STR_JUST_RAW_STRING, WL_ERROR);
+	} else {
+		DEBUG(sl, 0, "Background save process did not finish properly (status %d)", status);
+		ShowErrorMessage(STR_ERROR_AUTOSAVE_FAILED, INVALID_STRING_ID, WL_ERROR);
+	}
+}
+#endif /* defined(UNIX) && !defined(__MORPHOS__) */
+
 void WaitTillSaved()
 {
-	if (_save_thread == NULL) return;
+#if defined(UNIX) && !defined(__MORPHOS__)
+	CheckForkedSave(true);
+#endif
+
+	if (!_save_task) return;
 
-	_save_thread->Join();
-	delete _save_thread;
-	_save_thread = NULL;
+	_save_task->Join();
+	_save_task.reset();
 
 	/* Make sure every other state is handled properly as well. */
 	ProcessAsyncSaveFinish();
 }
 
+/**
+ * Check whether a savegame is being written, in a thread or in a background process.
+ * Starting another save now would have to wait for it to finish.
+ * @return True if a save is in progress.
+ */
+bool IsSaveInProgress()
+{
+	return _sl.saveinprogress;
+}
+
 /**
  * Actually perform the saving of the savegame.
  * General tactics is to first save the game to memory, then write it to file
@@ -2829,7 +3322,7 @@ static SaveOrLoadResult DoSave(SaveFilter *writer, bool threaded)
 	SlSaveChunks();
 
 	SaveFileStart();
-	if (!threaded || !ThreadObject::New(&SaveFileToDiskThread, NULL, &_save_thread, "ottd:savegame")) {
+	if (!threaded || !ThreadPool::Submit(&SaveFileToDiskThread, NULL, &_save_task, TPTF_BLOCKING, "ottd:savegame")) {
 		if (threaded) DEBUG(sl, 1, "Cannot create savegame thread, reverting to single-threaded mode...");
 
 		SaveOrLoadResult result = SaveFileToDisk(false);
@@ -3099,6 +3592,10 @@ SaveOrLoadResult SaveOrLoad(const char *filename, SaveLoadOperation fop, Detaile
 
 		if (fop == SLO_SAVE) { // SAVE game
 			DEBUG(desync, 1, "save: date{%08x; %02x; %02x}; %s", _date, _date_fract, _tick_skip_counter, filename);
+#if defined(UNIX) && !defined(__MORPHOS__)
+			/* Autosaves can be written by a forked copy of the game, so the game does not have to wait for them. */
+			if (threaded && _do_autosave && _settings_client.gui.fork_autosave && DoForkedSave(fh)) return SL_OK;
+#endif
 			if (_network_server || !_settings_client.gui.threaded_saves) threaded = false;
 
 			return DoSave(new FileWriter(fh), threaded);
@@ -56,6 +56,7 @@ void SetSaveLoadError(StringID str);
 const char *GetSaveLoadErrorString();
 SaveOrLoadResult SaveOrLoad(const char *filename, SaveLoadOperation fop, DetailedFileType dft, Subdirectory sb, bool threaded = true);
 void WaitTillSaved();
+bool IsSaveInProgress();
 void ProcessAsyncSaveFinish();
 void DoExitSave();
 
@@ -693,6 +694,7 @@ size_t SlCalcObjLength(const void *object, const SaveLoad *sld);
 
 byte SlReadByte();
 void SlWriteByte(byte b);
+void SlCopyBytes(void *ptr, size_t length);
 
 static inline int SlReadUint16()
 {
@@ -70,6 +70,7 @@
 #include "void_map.h"
 #include "station_base.h"
 #include "infrastructure_func.h"
+#include "pathfinder/water_regions.h"
 
 #include "table/strings.h"
 #include "table/settings.h"
@@ -1306,10 +1307,12 @@ static bool CheckFreeformEdges(int32 p1)
 		for (uint i = 0; i < MapMaxX(); i++) {
 			SetTileHeight(TileXY(i, 0), 0);
 			MakeSea(TileXY(i, 0));
+			InvalidateWaterRegion(TileXY(i, 0));
 		}
 		for (uint i = 0; i < MapMaxY(); i++) {
 			SetTileHeight(TileXY(0, i), 0);
 			MakeSea(TileXY(0, i));
+			InvalidateWaterRegion(TileXY(0, i));
 		}
 	}
 	MarkWholeScreenDirty();
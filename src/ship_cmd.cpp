@@ -36,6 +36,7 @@
 #include "infrastructure_func.h"
 #include "tunnelbridge_map.h"
 #include "zoom_func.h"
+#include "tick_timing.h"
 
 #include "table/strings.h"
 
@@ -728,6 +729,8 @@ reverse_direction:
 
 bool Ship::Tick()
 {
+	TickTimer timer(TTP_SHIPS);
+
 	if (!(this->vehstatus & VS_STOPPED)) this->running_ticks++;
 
 	ShipController(this);
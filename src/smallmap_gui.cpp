@@ -299,6 +299,9 @@ void BuildLandLegend()
  */
 void BuildOwnerLegend()
 {
+	/* The viewport map caches the company colours per tile. */
+	InvalidateViewportMapTileColourCache();
+
 	_legend_land_owners[1].colour = _heightmap_schemes[_settings_client.gui.smallmap_land_colour].default_colour;
 
 	int i = NUM_NO_COMPANY_ENTRIES;
@@ -464,6 +467,8 @@ static inline uint32 GetSmallMapOwnerPixels(TileIndex tile, TileType t)
 
 static void NotifyAllViewports(ViewportMapType map_type)
 {
+	InvalidateViewportMapTileColourCache();
+
 	Window *w;
 	FOR_ALL_WINDOWS_FROM_BACK(w) {
 		if (w->viewport != NULL)
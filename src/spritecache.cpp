@@ -19,6 +19,7 @@
 #include "blitter/factory.hpp"
 #include "core/math_func.hpp"
 #include "core/mem_func.hpp"
+#include "core/bitmath_func.hpp"
 
 #include "table/sprites.h"
 #include "table/strings.h"
@@ -37,8 +38,9 @@ struct SpriteCache {
 	void *ptr;
 	size_t file_pos;
 	uint32 id;
+	SpriteID lru_prev;   ///< Previous (more recently used) sprite in the LRU list, only valid while the sprite is in the list.
+	SpriteID lru_next;   ///< Next (less recently used) sprite in the LRU list, only valid while the sprite is in the list.
 	uint16 file_slot;
-	int16 lru;
 	SpriteTypeByte type; ///< In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
 	bool warned;         ///< True iff the user has been warned about incorrect use of this sprite
 	byte container_ver;  ///< Container version of the GRF the sprite is from.
@@ -78,17 +80,40 @@ static SpriteCache *AllocateSpriteCache(uint index)
 }
 
 
+/**
+ * Header of a block of the sprite cache heap.
+ * Free blocks store their #FreeBlockLinks in their data.
+ */
 struct MemBlock {
-	size_t size;
+	size_t size;      ///< Size of the block including this header; the lower bits are set when the block is free.
+	size_t prev_size; ///< Size of the block directly before this one in memory, 0 for the first block.
 	byte data[];
 };
 
-static uint _sprite_lru_counter;
+/** Links of a free block in the free list of its size class. */
+struct FreeBlockLinks {
+	MemBlock *prev; ///< Previous free block in the same size class.
+	MemBlock *next; ///< Next free block in the same size class.
+};
+
+/** Number of size classes of free blocks; class n holds the blocks of at least 2^n bytes. */
+static const uint FREE_LIST_CLASSES = 32;
+/** Number of blocks of the size class of a request that are checked before taking a block of a larger class. */
+static const uint FREE_LIST_FIT_TRIES = 8;
+/** No sprite, used as end of the LRU list. */
+static const SpriteID INVALID_LRU_SPRITE = UINT32_MAX;
+
+static uint32 _sprite_cache_generation; ///< Changed whenever cached sprites are freed or moved.
+static bool _sprite_cache_read_only;    ///< Whether the sprite cache may only be read, @see SetSpriteCacheReadOnly
 static MemBlock *_spritecache_ptr;
 static uint _allocated_sprite_cache_size = 0;
-static int _compact_cache_counter;
+static size_t _sprite_cache_used;                        ///< Number of bytes in use in the sprite cache heap.
+static MemBlock *_sprite_free_lists[FREE_LIST_CLASSES];  ///< Free blocks of the sprite cache heap, per size class.
+static uint32 _sprite_free_list_mask;                    ///< Bitmask of the size classes that have free blocks.
+static SpriteID _sprite_lru_head = INVALID_LRU_SPRITE;   ///< Most recently used cached sprite.
+static SpriteID _sprite_lru_tail = INVALID_LRU_SPRITE;   ///< Least recently used cached sprite, i.e. the first to be removed.
 
-static void CompactSpriteCache();
+static void DeleteEntryFromSpriteCache(uint item);
 static void *AllocSprite(size_t mem_req);
 
 /**
@@ -578,10 +603,10 @@ bool LoadNextSprite(int load_index, byte file_slot, uint file_sprite_id, byte co
 	}
 
 	SpriteCache *sc = AllocateSpriteCache(load_index);
+	if (sc->ptr != NULL && sc->type != ST_RECOLOUR) DeleteEntryFromSpriteCache(load_index);
 	sc->file_slot = file_slot;
 	sc->file_pos = file_pos;
 	sc->ptr = data;
-	sc->lru = 0;
 	sc->id = file_sprite_id;
 	sc->type = type;
 	sc->warned = false;
@@ -596,6 +621,8 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 	SpriteCache *scnew = AllocateSpriteCache(new_spr); // may reallocate: so put it first
 	SpriteCache *scold = GetSpriteCache(old_spr);
 
+	if (scnew->ptr != NULL && scnew->type != ST_RECOLOUR) DeleteEntryFromSpriteCache(new_spr);
+
 	scnew->file_slot = scold->file_slot;
 	scnew->file_pos = scold->file_pos;
 	scnew->ptr = NULL;
@@ -614,97 +641,158 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 static const size_t S_FREE_MASK = sizeof(size_t) - 1;
 
 /* to make sure nobody adds things to MemBlock without checking S_FREE_MASK first */
-assert_compile(sizeof(MemBlock) == sizeof(size_t));
+assert_compile(sizeof(MemBlock) == 2 * sizeof(size_t));
 /* make sure it's a power of two */
 assert_compile((sizeof(size_t) & (sizeof(size_t) - 1)) == 0);
 
-static inline MemBlock *NextBlock(MemBlock *block)
+/** Smallest possible block, a free block has to fit its links. */
+static const size_t S_MIN_BLOCK_SIZE = sizeof(MemBlock) + sizeof(FreeBlockLinks);
+
+static inline size_t GetBlockSize(const MemBlock *block)
 {
-	return (MemBlock*)((byte*)block + (block->size & ~S_FREE_MASK));
+	return block->size & ~S_FREE_MASK;
 }
 
-static size_t GetSpriteCacheUsage()
+static inline bool IsFreeBlock(const MemBlock *block)
 {
-	size_t tot_size = 0;
-	MemBlock *s;
-
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (!(s->size & S_FREE_MASK)) tot_size += s->size;
-	}
-
-	return tot_size;
+	return (block->size & S_FREE_MASK) != 0;
 }
 
+static inline MemBlock *NextBlock(MemBlock *block)
+{
+	return (MemBlock*)((byte*)block + GetBlockSize(block));
+}
 
-void IncreaseSpriteLRU()
+static inline FreeBlockLinks *GetFreeBlockLinks(MemBlock *block)
 {
-	/* Increase all LRU values */
-	if (_sprite_lru_counter > 16384) {
-		SpriteID i;
+	return (FreeBlockLinks*)block->data;
+}
 
-		DEBUG(sprite, 3, "Fixing lru %u, inuse=" PRINTF_SIZE, _sprite_lru_counter, GetSpriteCacheUsage());
+/**
+ * Get the size class of the free list of a block.
+ * @param size Size of the block.
+ * @return The size class, i.e. the index in #_sprite_free_lists.
+ */
+static inline uint GetFreeListClass(size_t size)
+{
+	return min<uint>(FindLastBit(size), FREE_LIST_CLASSES - 1);
+}
 
-		for (i = 0; i != _spritecache_items; i++) {
-			SpriteCache *sc = GetSpriteCache(i);
-			if (sc->ptr != NULL) {
-				if (sc->lru >= 0) {
-					sc->lru = -1;
-				} else if (sc->lru != -32768) {
-					sc->lru--;
-				}
-			}
-		}
-		_sprite_lru_counter = 0;
-	}
+/**
+ * Add a free block to the free list of its size class.
+ * @param block The block, which must be marked as free.
+ */
+static void AddToFreeList(MemBlock *block)
+{
+	uint cls = GetFreeListClass(GetBlockSize(block));
+	FreeBlockLinks *links = GetFreeBlockLinks(block);
+	links->prev = NULL;
+	links->next = _sprite_free_lists[cls];
+	if (links->next != NULL) GetFreeBlockLinks(links->next)->prev = block;
+	_sprite_free_lists[cls] = block;
+	SetBit(_sprite_free_list_mask, cls);
+}
 
-	/* Compact sprite cache every now and then. */
-	if (++_compact_cache_counter >= 740) {
-		CompactSpriteCache();
-		_compact_cache_counter = 0;
+/**
+ * Remove a free block from the free list of its size class.
+ * @param block The block.
+ */
+static void RemoveFromFreeList(MemBlock *block)
+{
+	uint cls = GetFreeListClass(GetBlockSize(block));
+	FreeBlockLinks *links = GetFreeBlockLinks(block);
+	if (links->prev != NULL) {
+		GetFreeBlockLinks(links->prev)->next = links->next;
+	} else {
+		_sprite_free_lists[cls] = links->next;
+		if (links->next == NULL) ClrBit(_sprite_free_list_mask, cls);
 	}
+	if (links->next != NULL) GetFreeBlockLinks(links->next)->prev = links->prev;
 }
 
 /**
- * Called when holes in the sprite cache should be removed.
- * That is accomplished by moving the cached data.
+ * Give a block back to the heap, merging it with the free blocks around it.
+ * @param block The block, which must be in use.
  */
-static void CompactSpriteCache()
+static void FreeBlock(MemBlock *block)
 {
-	MemBlock *s;
-
-	DEBUG(sprite, 3, "Compacting sprite cache, inuse=" PRINTF_SIZE, GetSpriteCacheUsage());
+	assert(!IsFreeBlock(block));
+	size_t size = block->size;
+	_sprite_cache_used -= size;
+
+	MemBlock *next = NextBlock(block);
+	if (IsFreeBlock(next)) {
+		RemoveFromFreeList(next);
+		size += GetBlockSize(next);
+	}
 
-	for (s = _spritecache_ptr; s->size != 0;) {
-		if (s->size & S_FREE_MASK) {
-			MemBlock *next = NextBlock(s);
-			MemBlock temp;
-			SpriteID i;
+	if (block->prev_size != 0) {
+		MemBlock *prev = (MemBlock*)((byte*)block - block->prev_size);
+		if (IsFreeBlock(prev)) {
+			RemoveFromFreeList(prev);
+			size += GetBlockSize(prev);
+			block = prev;
+		}
+	}
 
-			/* Since free blocks are automatically coalesced, this should hold true. */
-			assert(!(next->size & S_FREE_MASK));
+	block->size = size | S_FREE_MASK;
+	NextBlock(block)->prev_size = size;
+	AddToFreeList(block);
+}
 
-			/* If the next block is the sentinel block, we can safely return */
-			if (next->size == 0) break;
+/**
+ * Find a free block that is large enough.
+ * @param mem_req The required size of the block.
+ * @return The block, or NULL when there is no block large enough.
+ */
+static MemBlock *FindFreeBlock(size_t mem_req)
+{
+	/* Blocks of the same class might be too small, so only look at a few of them. */
+	uint cls = GetFreeListClass(mem_req);
+	MemBlock *s = _sprite_free_lists[cls];
+	for (uint i = 0; s != NULL && i < FREE_LIST_FIT_TRIES; i++, s = GetFreeBlockLinks(s)->next) {
+		if (GetBlockSize(s) >= mem_req) return s;
+	}
 
-			/* Locate the sprite belonging to the next pointer. */
-			for (i = 0; GetSpriteCache(i)->ptr != next->data; i++) {
-				assert(i != _spritecache_items);
-			}
+	/* Every block of a larger class is large enough. */
+	uint32 mask = _sprite_free_list_mask & ~(uint32)((2ULL << cls) - 1);
+	if (mask == 0) return NULL;
+	return _sprite_free_lists[FindFirstBit(mask)];
+}
 
-			GetSpriteCache(i)->ptr = s->data; // Adjust sprite array entry
-			/* Swap this and the next block */
-			temp = *s;
-			memmove(s, next, next->size);
-			s = NextBlock(s);
-			*s = temp;
+/**
+ * Add a cached sprite to the front of the LRU list.
+ * @param item The sprite.
+ */
+static void LinkSpriteLRU(SpriteID item)
+{
+	SpriteCache *sc = GetSpriteCache(item);
+	sc->lru_prev = INVALID_LRU_SPRITE;
+	sc->lru_next = _sprite_lru_head;
+	if (_sprite_lru_head != INVALID_LRU_SPRITE) {
+		GetSpriteCache(_sprite_lru_head)->lru_prev = item;
+	} else {
+		_sprite_lru_tail = item;
+	}
+	_sprite_lru_head = item;
+}
 
-			/* Coalesce free blocks */
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
-		} else {
-			s = NextBlock(s);
-		}
+/**
+ * Remove a cached sprite from the LRU list.
+ * @param item The sprite.
+ */
+static void UnlinkSpriteLRU(SpriteID item)
+{
+	SpriteCache *sc = GetSpriteCache(item);
+	if (sc->lru_prev != INVALID_LRU_SPRITE) {
+		GetSpriteCache(sc->lru_prev)->lru_next = sc->lru_next;
+	} else {
+		_sprite_lru_head = sc->lru_next;
+	}
+	if (sc->lru_next != INVALID_LRU_SPRITE) {
+		GetSpriteCache(sc->lru_next)->lru_prev = sc->lru_prev;
+	} else {
+		_sprite_lru_tail = sc->lru_prev;
 	}
 }
 
@@ -714,43 +802,25 @@ static void CompactSpriteCache()
  */
 static void DeleteEntryFromSpriteCache(uint item)
 {
-	/* Mark the block as free (the block must be in use) */
-	MemBlock *s = (MemBlock*)GetSpriteCache(item)->ptr - 1;
-	assert(!(s->size & S_FREE_MASK));
-	s->size |= S_FREE_MASK;
-	GetSpriteCache(item)->ptr = NULL;
+	/* Recolour sprites are never deleted, so they are not in the LRU list. */
+	assert(GetSpriteCache(item)->type != ST_RECOLOUR);
+	UnlinkSpriteLRU(item);
 
-	/* And coalesce adjacent free blocks */
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (s->size & S_FREE_MASK) {
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
-		}
-	}
+	FreeBlock((MemBlock*)GetSpriteCache(item)->ptr - 1);
+	GetSpriteCache(item)->ptr = NULL;
+	_sprite_cache_generation++;
 }
 
+/** Delete the least recently used entry from the sprite cache. */
 static void DeleteEntryFromSpriteCache()
 {
-	uint best = UINT_MAX;
-	int cur_lru;
-
-	DEBUG(sprite, 3, "DeleteEntryFromSpriteCache, inuse=" PRINTF_SIZE, GetSpriteCacheUsage());
-
-	cur_lru = 0xffff;
-	for (SpriteID i = 0; i != _spritecache_items; i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->type != ST_RECOLOUR && sc->ptr != NULL && sc->lru < cur_lru) {
-			cur_lru = sc->lru;
-			best = i;
-		}
-	}
+	DEBUG(sprite, 3, "DeleteEntryFromSpriteCache, inuse=" PRINTF_SIZE, _sprite_cache_used);
 
 	/* Display an error message and die, in case we found no sprite at all.
 	 * This shouldn't really happen, unless all sprites are locked. */
-	if (best == UINT_MAX) error("Out of sprite memory");
+	if (_sprite_lru_tail == INVALID_LRU_SPRITE) error("Out of sprite memory");
 
-	DeleteEntryFromSpriteCache(best);
+	DeleteEntryFromSpriteCache(_sprite_lru_tail);
 }
 
 static void *AllocSprite(size_t mem_req)
@@ -759,35 +829,30 @@ static void *AllocSprite(size_t mem_req)
 
 	/* Align this to correct boundary. This also makes sure at least one
 	 * bit is not used, so we can use it for other things. */
-	mem_req = Align(mem_req, S_FREE_MASK + 1);
-
-	for (;;) {
-		MemBlock *s;
+	mem_req = max(Align(mem_req, S_FREE_MASK + 1), S_MIN_BLOCK_SIZE);
 
-		for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-			if (s->size & S_FREE_MASK) {
-				size_t cur_size = s->size & ~S_FREE_MASK;
-
-				/* Is the block exactly the size we need or
-				 * big enough for an additional free block? */
-				if (cur_size == mem_req ||
-						cur_size >= mem_req + sizeof(MemBlock)) {
-					/* Set size and in use */
-					s->size = mem_req;
-
-					/* Do we need to inject a free block too? */
-					if (cur_size != mem_req) {
-						NextBlock(s)->size = (cur_size - mem_req) | S_FREE_MASK;
-					}
-
-					return s->data;
-				}
-			}
-		}
-
-		/* Reached sentinel, but no block found yet. Delete some old entry. */
+	MemBlock *s;
+	while ((s = FindFreeBlock(mem_req)) == NULL) {
+		/* No block large enough. Delete some old entry. */
 		DeleteEntryFromSpriteCache();
 	}
+
+	RemoveFromFreeList(s);
+	size_t cur_size = GetBlockSize(s);
+	if (cur_size - mem_req >= S_MIN_BLOCK_SIZE) {
+		/* Split off the remainder as a new free block. */
+		s->size = mem_req;
+		MemBlock *rest = NextBlock(s);
+		rest->size = (cur_size - mem_req) | S_FREE_MASK;
+		rest->prev_size = mem_req;
+		NextBlock(rest)->prev_size = cur_size - mem_req;
+		AddToFreeList(rest);
+	} else {
+		s->size = cur_size;
+	}
+	_sprite_cache_used += s->size;
+
+	return s->data;
 }
 
 /**
@@ -862,11 +927,21 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 	if (allocator == NULL) {
 		/* Load sprite into/from spritecache */
 
-		/* Update LRU */
-		sc->lru = ++_sprite_lru_counter;
+		if (_sprite_cache_read_only) {
+			/* Concurrent readers may only use sprites which are in the cache already. */
+			assert(sc->ptr != NULL);
+			return sc->ptr;
+		}
 
-		/* Load the sprite, if it is not loaded, yet */
-		if (sc->ptr == NULL) sc->ptr = ReadSprite(sc, sprite, type, AllocSprite);
+		if (sc->ptr == NULL) {
+			/* Load the sprite, if it is not loaded, yet */
+			sc->ptr = ReadSprite(sc, sprite, type, AllocSprite);
+			if (type != ST_RECOLOUR) LinkSpriteLRU(sprite);
+		} else if (type != ST_RECOLOUR && _sprite_lru_head != sprite) {
+			/* Update LRU */
+			UnlinkSpriteLRU(sprite);
+			LinkSpriteLRU(sprite);
+		}
 
 		return sc->ptr;
 	} else {
@@ -875,6 +950,27 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator)
 	}
 }
 
+/**
+ * Get a counter which changes whenever sprites in the sprite cache are freed or moved.
+ * As long as it does not change, the pointers returned by #GetRawSprite stay valid.
+ * @return The current generation of the sprite cache.
+ */
+uint32 GetSpriteCacheGeneration()
+{
+	return _sprite_cache_generation;
+}
+
+/**
+ * Allow or disallow changing the sprite cache.
+ * While the sprite cache is read-only, #GetRawSprite may be called from several threads at once,
+ * but only for sprites which are already cached; it does not update the LRU information then.
+ * @param read_only Whether the sprite cache is read-only.
+ */
+void SetSpriteCacheReadOnly(bool read_only)
+{
+	_sprite_cache_read_only = read_only;
+}
+
 /**
  * Reads a sprite and finds its most representative colour.
  * @param sprite Sprite to read.
@@ -983,6 +1079,7 @@ static void GfxInitSpriteCache()
 
 	if (_spritecache_ptr == NULL || (_allocated_sprite_cache_size != target_size && target_size != last_alloc_attempt)) {
 		delete[] reinterpret_cast<byte *>(_spritecache_ptr);
+		_sprite_cache_generation++;
 
 		last_alloc_attempt = target_size;
 		_allocated_sprite_cache_size = target_size;
@@ -1018,9 +1115,18 @@ static void GfxInitSpriteCache()
 	}
 
 	/* A big free block */
+	MemSetT(_sprite_free_lists, 0, lengthof(_sprite_free_lists));
+	_sprite_free_list_mask = 0;
+	_sprite_cache_used = 0;
 	_spritecache_ptr->size = (_allocated_sprite_cache_size - sizeof(MemBlock)) | S_FREE_MASK;
+	_spritecache_ptr->prev_size = 0;
+	AddToFreeList(_spritecache_ptr);
 	/* Sentinel block (identified by size == 0) */
 	NextBlock(_spritecache_ptr)->size = 0;
+	NextBlock(_spritecache_ptr)->prev_size = GetBlockSize(_spritecache_ptr);
+
+	_sprite_lru_head = INVALID_LRU_SPRITE;
+	_sprite_lru_tail = INVALID_LRU_SPRITE;
 }
 
 void GfxInitSpriteMem()
@@ -1031,8 +1137,6 @@ void GfxInitSpriteMem()
 	free(_spritecache);
 	_spritecache_items = 0;
 	_spritecache = NULL;
-
-	_compact_cache_counter = 0;
 }
 
 /**
@@ -30,6 +30,9 @@ typedef void *AllocatorProc(size_t size);
 void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator = NULL);
 bool SpriteExists(SpriteID sprite);
 
+uint32 GetSpriteCacheGeneration();
+void SetSpriteCacheReadOnly(bool read_only);
+
 SpriteType GetSpriteType(SpriteID sprite);
 uint GetOriginFileSlot(SpriteID sprite);
 uint GetSpriteCountForSlot(uint file_slot, SpriteID begin, SpriteID end);
@@ -50,7 +53,6 @@ static inline const byte *GetNonSprite(SpriteID sprite, SpriteType type)
 
 void GfxInitSpriteMem();
 void GfxClearSpriteCache();
-void IncreaseSpriteLRU();
 
 void ReadGRFSpriteOffsets(byte container_version);
 size_t GetGRFSpriteOffset(uint32 id);
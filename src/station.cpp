@@ -28,6 +28,8 @@
 #include "linkgraph/linkgraph.h"
 #include "linkgraph/linkgraphschedule.h"
 #include "tracerestrict.h"
+#include "station_func.h"
+#include <algorithm>
 
 #include "table/strings.h"
 
@@ -67,6 +69,9 @@ Station::Station(TileIndex tile) :
 	last_vehicle_type(VEH_INVALID)
 {
 	/* this->random_bits is set in Station::AddFacility() */
+
+	/* Not listed in the catchment index until Station::RecomputeIndustriesNear() */
+	this->catchment_index_blocks = { 0, 0, -1, -1 };
 }
 
 /**
@@ -78,6 +83,8 @@ Station::Station(TileIndex tile) :
  */
 Station::~Station()
 {
+	this->RemoveFromCatchmentIndex();
+
 	if (CleaningPool()) {
 		for (CargoID c = 0; c < NUM_CARGO; c++) {
 			this->goods[c].cargo.OnCleanPool();
@@ -361,6 +368,8 @@ static bool FindIndustryToDeliver(TileIndex ind_tile, void *user_data)
  */
 void Station::RecomputeIndustriesNear()
 {
+	this->UpdateCatchmentIndex();
+
 	this->industries_near.Clear();
 	if (this->rect.IsEmpty()) return;
 
@@ -388,6 +397,116 @@ void Station::RecomputeIndustriesNear()
 	FOR_ALL_STATIONS(st) st->RecomputeIndustriesNear();
 }
 
+/** Log2 of the edge length of the blocks of the station catchment index, in tiles. */
+static const uint STATION_CATCHMENT_INDEX_BLOCK_SHIFT = 4;
+
+/**
+ * For each block of the map, the stations of which the largest possible catchment area covers a tile of the block.
+ * A station is listed in a block when its station rectangle extended by the largest possible catchment radius overlaps the block.
+ */
+static std::vector<std::vector<StationID>> _station_catchment_index;
+static uint _station_catchment_index_width; ///< Width of the station catchment index, in blocks.
+
+/**
+ * Get the catchment radius the station catchment index is built with.
+ * This is never smaller than the catchment radius of a station, so the index only needs
+ * rebuilding when the catchment settings change, not when station facilities change.
+ * @return The largest catchment radius of a station with the current settings.
+ */
+static uint GetStationCatchmentIndexRadius()
+{
+	return (_settings_game.station.modified_catchment ? MAX_CATCHMENT : CA_UNMODIFIED) + _settings_game.station.catchment_increase;
+}
+
+/**
+ * (Re)allocate the station catchment index for the current map size.
+ * Stations have to be added again via Station::RecomputeIndustriesNear().
+ */
+void AllocateStationCatchmentIndex()
+{
+	_station_catchment_index_width = MapSizeX() >> STATION_CATCHMENT_INDEX_BLOCK_SHIFT;
+	_station_catchment_index.clear();
+	_station_catchment_index.resize(_station_catchment_index_width * (MapSizeY() >> STATION_CATCHMENT_INDEX_BLOCK_SHIFT));
+}
+
+/**
+ * Add the stations of which the catchment may cover a tile of an area to a list.
+ * The result is a superset, the caller has to check the actual catchment of each station.
+ * @param area The area to look for stations around.
+ * @param stations The list to add the stations to.
+ */
+void GetStationCatchmentIndexCandidates(const TileArea &area, StationList *stations)
+{
+	if (area.w == 0 || area.h == 0 || _station_catchment_index.empty()) return;
+
+	uint max_x = (MapSizeX() >> STATION_CATCHMENT_INDEX_BLOCK_SHIFT) - 1;
+	uint max_y = (MapSizeY() >> STATION_CATCHMENT_INDEX_BLOCK_SHIFT) - 1;
+	uint left   = min<uint>(TileX(area.tile) >> STATION_CATCHMENT_INDEX_BLOCK_SHIFT, max_x);
+	uint top    = min<uint>(TileY(area.tile) >> STATION_CATCHMENT_INDEX_BLOCK_SHIFT, max_y);
+	uint right  = min<uint>((TileX(area.tile) + area.w - 1) >> STATION_CATCHMENT_INDEX_BLOCK_SHIFT, max_x);
+	uint bottom = min<uint>((TileY(area.tile) + area.h - 1) >> STATION_CATCHMENT_INDEX_BLOCK_SHIFT, max_y);
+
+	for (uint y = top; y <= bottom; y++) {
+		for (uint x = left; x <= right; x++) {
+			const std::vector<StationID> &block = _station_catchment_index[y * _station_catchment_index_width + x];
+			for (std::vector<StationID>::const_iterator it = block.begin(); it != block.end(); ++it) {
+				stations->Include(Station::Get(*it));
+			}
+		}
+	}
+}
+
+/**
+ * Update the blocks of the station catchment index this station is listed in,
+ * after the station rectangle or the catchment settings changed.
+ */
+void Station::UpdateCatchmentIndex()
+{
+	Rect blocks = { 0, 0, -1, -1 };
+	if (!this->rect.IsEmpty()) {
+		Rect catchment = this->GetCatchmentRectUsingRadius(GetStationCatchmentIndexRadius());
+		blocks.left   = catchment.left   >> STATION_CATCHMENT_INDEX_BLOCK_SHIFT;
+		blocks.top    = catchment.top    >> STATION_CATCHMENT_INDEX_BLOCK_SHIFT;
+		blocks.right  = catchment.right  >> STATION_CATCHMENT_INDEX_BLOCK_SHIFT;
+		blocks.bottom = catchment.bottom >> STATION_CATCHMENT_INDEX_BLOCK_SHIFT;
+	}
+
+	const Rect &old = this->catchment_index_blocks;
+	if (old.left == blocks.left && old.top == blocks.top && old.right == blocks.right && old.bottom == blocks.bottom) return;
+
+	this->RemoveFromCatchmentIndex();
+
+	for (int y = blocks.top; y <= blocks.bottom; y++) {
+		for (int x = blocks.left; x <= blocks.right; x++) {
+			_station_catchment_index[y * _station_catchment_index_width + x].push_back(this->index);
+		}
+	}
+	this->catchment_index_blocks = blocks;
+}
+
+/**
+ * Remove this station from all blocks of the station catchment index.
+ */
+void Station::RemoveFromCatchmentIndex()
+{
+	const Rect &blocks = this->catchment_index_blocks;
+	for (int y = blocks.top; y <= blocks.bottom; y++) {
+		for (int x = blocks.left; x <= blocks.right; x++) {
+			/* The index may have been reallocated since the station was added to it. */
+			size_t block_index = y * _station_catchment_index_width + x;
+			if (block_index >= _station_catchment_index.size()) continue;
+
+			std::vector<StationID> &block = _station_catchment_index[block_index];
+			std::vector<StationID>::iterator it = std::find(block.begin(), block.end(), this->index);
+			if (it != block.end()) {
+				*it = block.back();
+				block.pop_back();
+			}
+		}
+	}
+	this->catchment_index_blocks = { 0, 0, -1, -1 };
+}
+
 /************************************************************************/
 /*                     StationRect implementation                       */
 /************************************************************************/
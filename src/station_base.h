@@ -476,6 +476,7 @@ public:
 	uint32 always_accepted;       ///< Bitmask of always accepted cargo types (by houses, HQs, industry tiles when industry doesn't accept cargo)
 
 	IndustryVector industries_near; ///< Cached list of industries near the station that can accept cargo, @see DeliverGoodsToIndustry()
+	Rect catchment_index_blocks;    ///< Blocks of the station catchment index this station is listed in, empty (right < left) if none, @see FindStationsAroundTiles()
 
 	Station(TileIndex tile = INVALID_TILE);
 	~Station();
@@ -491,6 +492,9 @@ public:
 	void RecomputeIndustriesNear();
 	static void RecomputeIndustriesNearForAll();
 
+	void UpdateCatchmentIndex();
+	void RemoveFromCatchmentIndex();
+
 	Dock *GetPrimaryDock() const { return docks; }
 
 	uint GetCatchmentRadius() const;
@@ -46,6 +46,7 @@
 #include "debug.h"
 #include "core/random_func.hpp"
 #include "company_base.h"
+#include "tick_timing.h"
 #include "table/airporttile_ids.h"
 #include "newgrf_airporttiles.h"
 #include "order_backup.h"
@@ -55,6 +56,9 @@
 #include "linkgraph/refresh.h"
 #include "widgets/station_widget.h"
 #include "zoning.h"
+#include "pathfinder/water_regions.h"
+#include <algorithm>
+#include <vector>
 
 #include "table/strings.h"
 
@@ -2673,6 +2677,8 @@ CommandCost CmdBuildDock(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 		DirtyCompanyInfrastructureWindows(st->owner);
 
 		MakeDock(slope_tile, st->owner, st->index, direction, wc);
+		InvalidateWaterRegion(slope_tile);
+		InvalidateWaterRegion(flat_tile);
 
 		st->UpdateVirtCoord();
 		UpdateStationAcceptance(st, false);
@@ -3765,6 +3771,8 @@ static void StationHandleSmallTick(BaseStation *st)
 
 void OnTick_Station()
 {
+	TickTimer timer(TTP_STATIONS);
+
 	if (_game_mode == GM_EDITOR) return;
 
 	BaseStation *st;
@@ -3914,6 +3922,7 @@ CommandCost CmdRenameStation(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 
 /**
  * Find all stations around a rectangular producer (industry, house, headquarter, ...)
+ * Only the stations listed in the station catchment index for the area are checked.
  *
  * @param location The location/area of the producer
  * @param stations The list to store the stations in
@@ -3924,47 +3933,62 @@ void FindStationsAroundTiles(const TileArea &location, StationList *stations)
 	uint max_rad = (_settings_game.station.modified_catchment ? MAX_CATCHMENT : CA_UNMODIFIED);
 	max_rad += _settings_game.station.catchment_increase;
 
-	uint x = TileX(location.tile);
-	uint y = TileY(location.tile);
+	int x = TileX(location.tile);
+	int y = TileY(location.tile);
 
-	uint min_x = (x > max_rad) ? x - max_rad : 0;
-	uint max_x = x + location.w + max_rad;
-	uint min_y = (y > max_rad) ? y - max_rad : 0;
-	uint max_y = y + location.h + max_rad;
+	int min_x = max<int>(x - max_rad, 0);
+	int max_x = x + location.w + max_rad;
+	int min_y = max<int>(y - max_rad, 0);
+	int max_y = y + location.h + max_rad;
 
 	if (min_x == 0 && _settings_game.construction.freeform_edges) min_x = 1;
 	if (min_y == 0 && _settings_game.construction.freeform_edges) min_y = 1;
-	if (max_x >= MapSizeX()) max_x = MapSizeX() - 1;
-	if (max_y >= MapSizeY()) max_y = MapSizeY() - 1;
-
-	for (uint cy = min_y; cy < max_y; cy++) {
-		for (uint cx = min_x; cx < max_x; cx++) {
-			TileIndex cur_tile = TileXY(cx, cy);
-			if (!IsTileType(cur_tile, MP_STATION)) continue;
+	if (max_x >= (int)MapSizeX()) max_x = MapSizeX() - 1;
+	if (max_y >= (int)MapSizeY()) max_y = MapSizeY() - 1;
 
-			Station *st = Station::GetByTile(cur_tile);
-			/* st can be NULL in case of waypoints */
-			if (st == NULL) continue;
+	StationList candidates;
+	GetStationCatchmentIndexCandidates(location, &candidates);
 
-			if (_settings_game.station.modified_catchment) {
-				int rad = st->GetCatchmentRadius();
-				int rad_x = cx - x;
-				int rad_y = cy - y;
+	/* For each station in reach, the first of its tiles in the search area.
+	 * The stations are added in the order of those tiles, as if the whole search area was scanned. */
+	std::vector<std::pair<TileIndex, Station *>> found;
 
-				if (rad_x < -rad || rad_x >= rad + location.w) continue;
-				if (rad_y < -rad || rad_y >= rad + location.h) continue;
+	for (Station * const *st_iter = candidates.Begin(); st_iter != candidates.End(); ++st_iter) {
+		Station *st = *st_iter;
+		if (st->rect.IsEmpty()) continue;
+
+		int rad = _settings_game.station.modified_catchment ? (int)st->GetCatchmentRadius() : (int)max_rad;
+
+		/* Only the tiles of the station rectangle within the station's own catchment radius of the location can match. */
+		int left   = max(max(min_x, x - rad), st->rect.left);
+		int right  = min(min(max_x - 1, x + location.w + rad - 1), st->rect.right);
+		int top    = max(max(min_y, y - rad), st->rect.top);
+		int bottom = min(min(max_y - 1, y + location.h + rad - 1), st->rect.bottom);
+
+		for (int cy = top; cy <= bottom; cy++) {
+			for (int cx = left; cx <= right; cx++) {
+				TileIndex cur_tile = TileXY(cx, cy);
+				if (IsTileType(cur_tile, MP_STATION) && GetStationIndex(cur_tile) == st->index) {
+					found.push_back(std::make_pair(cur_tile, st));
+					goto next_station;
+				}
 			}
-
-			/* Insert the station in the set. This will fail if it has
-			 * already been added.
-			 */
-			stations->Include(st);
 		}
+next_station:;
+	}
+
+	std::sort(found.begin(), found.end());
+
+	for (std::vector<std::pair<TileIndex, Station *>>::const_iterator it = found.begin(); it != found.end(); ++it) {
+		/* Insert the station in the set. This will fail if it has
+		 * already been added.
+		 */
+		stations->Include(it->second);
 	}
 }
 
 /**
- * Run a tile loop to find stations around a tile, on demand. Cache the result for further requests
+ * Find the stations around the area of the finder on demand, using the station catchment index. Cache the result for further requests
  * @return pointer to a StationList containing all stations found
  */
 const StationList *StationFinder::GetStations()
@@ -4057,6 +4081,7 @@ void BuildOilRig(TileIndex tile)
 	assert(IsTileType(tile, MP_INDUSTRY));
 	DeleteAnimatedTile(tile);
 	MakeOilrig(tile, st->index, GetWaterClass(tile));
+	InvalidateWaterRegion(tile);
 
 	st->owner = OWNER_NONE;
 	st->airport.type = AT_OILRIG;
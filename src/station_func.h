@@ -24,6 +24,9 @@ void ModifyStationRatingAround(TileIndex tile, Owner owner, int amount, uint rad
 
 void FindStationsAroundTiles(const TileArea &location, StationList *stations);
 
+void AllocateStationCatchmentIndex();
+void GetStationCatchmentIndexCandidates(const TileArea &area, StationList *stations);
+
 void ShowStationViewWindow(StationID station);
 void UpdateAllStationVirtCoords();
 
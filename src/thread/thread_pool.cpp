@@ -0,0 +1,494 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_pool.cpp Implementation of the shared pool of worker threads. */
+
+#include "../stdafx.h"
+#include "../debug.h"
+#include "../core/math_func.hpp"
+#include "thread_pool.h"
+#include <deque>
+#include <vector>
+#include <algorithm>
+
+#include "../safeguards.h"
+
+/** A worker thread of the pool. */
+struct ThreadPoolWorker {
+	std::deque<ThreadPoolHandle> queue; ///< Tasks submitted from this worker, protected by the pool mutex.
+	ThreadObject *thread;               ///< The thread of the worker.
+	ThreadMutex *wake_mutex;            ///< Mutex to wait for work on.
+	bool woken;                         ///< Whether the worker has been woken up, protected by #wake_mutex.
+};
+
+static const uint MAX_POOL_WORKERS = 64;    ///< Upper limit to the number of worker threads.
+static const uint MAX_BLOCKING_WORKERS = 8; ///< Upper limit to the number of threads for blocking tasks.
+
+/** State of the thread pool. */
+struct ThreadPoolState {
+	ThreadMutex *mutex;                        ///< Mutex protecting the queues, the idle lists and the blocking workers.
+	ThreadPoolWorker workers[MAX_POOL_WORKERS]; ///< All workers; only the first #worker_count are in use.
+	uint worker_count;                         ///< Number of started workers.
+	std::deque<ThreadPoolHandle> shared_queue; ///< Tasks submitted from threads which are not workers.
+	std::vector<ThreadPoolWorker *> idle;      ///< Workers waiting for work.
+
+	ThreadPoolWorker blocking_workers[MAX_BLOCKING_WORKERS]; ///< Threads for blocking tasks; only the first #blocking_worker_count are in use.
+	uint blocking_worker_count;                              ///< Number of started blocking workers.
+	std::deque<ThreadPoolHandle> blocking_queue;             ///< Blocking tasks waiting for a blocking worker.
+	std::vector<ThreadPoolWorker *> blocking_idle;           ///< Blocking workers waiting for work.
+
+	bool shutting_down;                        ///< Whether workers should exit once there is no work left.
+};
+
+/** The thread pool. */
+static ThreadPoolState *_pool = NULL;
+
+/** Index of the worker the current thread is, or -1 if it is not a worker. */
+static thread_local int _pool_current_worker = -1;
+
+ThreadPoolTask::ThreadPoolTask(std::function<void()> proc, ThreadPoolTaskFlags flags, const char *name) :
+	proc(std::move(proc)), flags(flags), name(name), mutex(ThreadMutex::New()), state(TS_QUEUED), queue(-1) {}
+
+ThreadPoolTask::~ThreadPoolTask()
+{
+	delete this->mutex;
+}
+
+/**
+ * Get the state of the task.
+ * The state can be read by other threads without holding a mutex, hence the atomic access.
+ * @return The state.
+ */
+ThreadPoolTask::State ThreadPoolTask::GetState() const
+{
+#if defined(__GNUC__) || defined(__clang__)
+	return __atomic_load_n(&(this->state), __ATOMIC_ACQUIRE);
+#else
+	return this->state;
+#endif
+}
+
+/**
+ * Set the state of the task.
+ * @param state The new state.
+ */
+void ThreadPoolTask::SetState(State state)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	__atomic_store_n(&(this->state), state, __ATOMIC_RELEASE);
+#else
+	this->state = state;
+#endif
+}
+
+/** Run the task in the current thread and mark it done. */
+void ThreadPoolTask::Run()
+{
+	try {
+		this->proc();
+	} catch (OTTDThreadExitSignal) {
+	}
+	this->proc = nullptr;
+
+	this->mutex->BeginCritical();
+	this->SetState(TS_DONE);
+	this->mutex->SendSignal();
+	this->mutex->EndCritical();
+}
+
+/**
+ * Check whether the task has finished.
+ * @return true if the task has finished.
+ */
+bool ThreadPoolTask::IsFinished() const
+{
+	return this->GetState() == TS_DONE;
+}
+
+/**
+ * Wait for the task to finish. If no worker has started it yet, and it is neither a
+ * blocking nor a long task, run it in the current thread instead. A long task is moved
+ * to the front of the shared queue instead, so the next free worker takes it.
+ * @note Only one thread may join a task.
+ */
+void ThreadPoolTask::Join()
+{
+	if (this->IsFinished()) return;
+
+	if (!(this->flags & TPTF_BLOCKING)) {
+		_pool->mutex->BeginCritical();
+		if (this->GetState() == TS_QUEUED) {
+			std::deque<ThreadPoolHandle> &queue = (this->queue < 0) ? _pool->shared_queue : _pool->workers[this->queue].queue;
+			auto iter = std::find_if(queue.begin(), queue.end(), [&](const ThreadPoolHandle &h) { return h.get() == this; });
+			assert(iter != queue.end());
+			ThreadPoolHandle self = *iter; // Keep us alive while running.
+			queue.erase(iter);
+
+			if (!(this->flags & TPTF_LONG)) {
+				this->SetState(TS_RUNNING);
+				_pool->mutex->EndCritical();
+
+				this->Run();
+				return;
+			}
+
+			/* Running it here would stall the joining thread (e.g. the game loop) for as long as the task takes. */
+			this->queue = -1;
+			_pool->shared_queue.push_front(std::move(self));
+		}
+		_pool->mutex->EndCritical();
+	}
+
+	this->mutex->BeginCritical();
+	while (this->GetState() != TS_DONE) this->mutex->WaitForSignal();
+	this->mutex->EndCritical();
+}
+
+/**
+ * Take the next task for a worker: first from its own queue (newest first),
+ * then from the shared queue, and finally steal from the other workers (oldest first).
+ * @param index Index of the worker.
+ * @return The task, or NULL if there is none.
+ * @pre The pool mutex is held.
+ */
+/* static */ ThreadPoolHandle ThreadPool::TakeTask(uint index)
+{
+	ThreadPoolHandle task;
+	std::deque<ThreadPoolHandle> &own = _pool->workers[index].queue;
+	if (!own.empty()) {
+		task = std::move(own.back());
+		own.pop_back();
+	} else if (!_pool->shared_queue.empty()) {
+		task = std::move(_pool->shared_queue.front());
+		_pool->shared_queue.pop_front();
+	} else {
+		for (uint i = 1; i < _pool->worker_count; i++) {
+			std::deque<ThreadPoolHandle> &other = _pool->workers[(index + i) % _pool->worker_count].queue;
+			if (other.empty()) continue;
+			task = std::move(other.front());
+			other.pop_front();
+			break;
+		}
+	}
+	if (task) task->SetState(ThreadPoolTask::TS_RUNNING);
+	return task;
+}
+
+/**
+ * Wake up an idle worker, if there is one.
+ * @param idle List of idle workers to take the worker from.
+ * @return true if a worker has been woken up.
+ * @pre The pool mutex is held.
+ */
+static bool WakeIdleWorker(std::vector<ThreadPoolWorker *> &idle)
+{
+	if (idle.empty()) return false;
+
+	ThreadPoolWorker *worker = idle.back();
+	idle.pop_back();
+
+	worker->wake_mutex->BeginCritical();
+	worker->woken = true;
+	worker->wake_mutex->SendSignal();
+	worker->wake_mutex->EndCritical();
+	return true;
+}
+
+/**
+ * Main loop of a worker thread.
+ * @param param Index of the worker.
+ */
+/* static */ void ThreadPool::WorkerProc(void *param)
+{
+	uint index = (uint)(size_t)param;
+	ThreadPoolWorker &worker = _pool->workers[index];
+	_pool_current_worker = index;
+
+	for (;;) {
+		_pool->mutex->BeginCritical();
+		ThreadPoolHandle task = TakeTask(index);
+		if (!task) {
+			if (_pool->shutting_down) {
+				_pool->mutex->EndCritical();
+				return;
+			}
+			_pool->idle.push_back(&worker);
+			_pool->mutex->EndCritical();
+
+			worker.wake_mutex->BeginCritical();
+			while (!worker.woken) worker.wake_mutex->WaitForSignal();
+			worker.woken = false;
+			worker.wake_mutex->EndCritical();
+			continue;
+		}
+		_pool->mutex->EndCritical();
+
+		task->Run();
+	}
+}
+
+/**
+ * Start the worker threads.
+ * This must be called once by the main thread, before any other function of the pool is used.
+ */
+/* static */ void ThreadPool::Init()
+{
+	assert(_pool == NULL);
+	_pool = new ThreadPoolState();
+	_pool->mutex = ThreadMutex::New();
+	_pool->worker_count = 0;
+	_pool->blocking_worker_count = 0;
+	_pool->shutting_down = false;
+
+	uint count = Clamp<uint>(GetCPUCoreCount(), 2, MAX_POOL_WORKERS);
+	_pool->idle.reserve(count);
+	_pool->blocking_idle.reserve(MAX_BLOCKING_WORKERS);
+
+	_pool->mutex->BeginCritical();
+	for (uint i = 0; i < count; i++) {
+		ThreadPoolWorker &worker = _pool->workers[i];
+		worker.wake_mutex = ThreadMutex::New();
+		worker.woken = false;
+		if (!ThreadObject::New(&ThreadPool::WorkerProc, (void *)(size_t)i, &worker.thread, "ottd:worker")) {
+			delete worker.wake_mutex;
+			worker.wake_mutex = NULL;
+			break;
+		}
+		_pool->worker_count++;
+	}
+	_pool->mutex->EndCritical();
+
+	DEBUG(misc, 2, "Thread pool: started %u worker threads", _pool->worker_count);
+}
+
+/**
+ * Stop the worker threads. Tasks which are still queued are run first. Blocking workers
+ * which are busy are not waited for, as their tasks may take long (e.g. network timeouts);
+ * they exit on their own, and the pool state is kept for them.
+ * Afterwards tasks are run by their submitters.
+ */
+/* static */ void ThreadPool::Shutdown()
+{
+	if (_pool == NULL) return;
+
+	_pool->mutex->BeginCritical();
+	_pool->shutting_down = true;
+	while (WakeIdleWorker(_pool->idle)) {}
+	std::vector<ThreadPoolWorker *> idle_blocking = _pool->blocking_idle;
+	bool blocking_busy = idle_blocking.size() < _pool->blocking_worker_count;
+	while (WakeIdleWorker(_pool->blocking_idle)) {}
+	_pool->mutex->EndCritical();
+
+	for (uint i = 0; i < _pool->worker_count; i++) {
+		ThreadPoolWorker &worker = _pool->workers[i];
+		worker.thread->Join();
+		delete worker.thread;
+		delete worker.wake_mutex;
+	}
+	for (ThreadPoolWorker *worker : idle_blocking) {
+		worker->thread->Join();
+		delete worker->thread;
+		delete worker->wake_mutex;
+	}
+
+	DEBUG(misc, 2, "Thread pool: stopped %u worker threads", _pool->worker_count);
+	_pool->worker_count = 0;
+	if (blocking_busy) return;
+
+	delete _pool->mutex;
+	delete _pool;
+	_pool = NULL;
+}
+
+/**
+ * Main loop of a thread for blocking tasks.
+ * @param param Index of the blocking worker.
+ */
+/* static */ void ThreadPool::BlockingWorkerProc(void *param)
+{
+	ThreadPoolWorker &worker = _pool->blocking_workers[(size_t)param];
+
+	for (;;) {
+		_pool->mutex->BeginCritical();
+		if (_pool->blocking_queue.empty()) {
+			if (_pool->shutting_down) {
+				_pool->mutex->EndCritical();
+				return;
+			}
+			_pool->blocking_idle.push_back(&worker);
+			_pool->mutex->EndCritical();
+
+			worker.wake_mutex->BeginCritical();
+			while (!worker.woken) worker.wake_mutex->WaitForSignal();
+			worker.woken = false;
+			worker.wake_mutex->EndCritical();
+			continue;
+		}
+		ThreadPoolHandle task = std::move(_pool->blocking_queue.front());
+		_pool->blocking_queue.pop_front();
+		task->SetState(ThreadPoolTask::TS_RUNNING);
+		_pool->mutex->EndCritical();
+
+		task->Run();
+	}
+}
+
+/**
+ * Start another thread for blocking tasks, if the limit has not been reached yet.
+ * @return true if a thread has been started.
+ * @pre The pool mutex is held.
+ */
+/* static */ bool ThreadPool::StartBlockingWorker()
+{
+	if (_pool->blocking_worker_count == MAX_BLOCKING_WORKERS) return false;
+
+	uint index = _pool->blocking_worker_count;
+	ThreadPoolWorker &worker = _pool->blocking_workers[index];
+	worker.wake_mutex = ThreadMutex::New();
+	worker.woken = false;
+	/* Count it before it runs, it reads the state under the pool mutex which we hold. */
+	_pool->blocking_worker_count++;
+	if (!ThreadObject::New(&ThreadPool::BlockingWorkerProc, (void *)(size_t)index, &worker.thread, "ottd:blocking")) {
+		_pool->blocking_worker_count--;
+		delete worker.wake_mutex;
+		worker.wake_mutex = NULL;
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Submit a task to the thread pool.
+ * @param proc The work to do.
+ * @param handle Place to store the handle of the task in. May be NULL.
+ * @param flags Flags of the task.
+ * @param name A name for the task. May be NULL.
+ * @return True if the task has been submitted, false if there are no threads, in which case the caller should do the work itself.
+ */
+/* static */ bool ThreadPool::Submit(std::function<void()> proc, ThreadPoolHandle *handle, ThreadPoolTaskFlags flags, const char *name)
+{
+	if (handle != NULL) handle->reset();
+	if (_pool == NULL || _pool->worker_count == 0) return false;
+
+	ThreadPoolHandle task = std::make_shared<ThreadPoolTask>(std::move(proc), flags, name);
+
+	if (flags & TPTF_BLOCKING) {
+		/* Blocking tasks would keep a worker from computational tasks for a long time. */
+		_pool->mutex->BeginCritical();
+		if (!WakeIdleWorker(_pool->blocking_idle) && !StartBlockingWorker() && _pool->blocking_worker_count == 0) {
+			_pool->mutex->EndCritical();
+			return false;
+		}
+		_pool->blocking_queue.push_back(task);
+		_pool->mutex->EndCritical();
+
+		if (handle != NULL) *handle = std::move(task);
+		return true;
+	}
+
+	_pool->mutex->BeginCritical();
+	task->queue = _pool_current_worker;
+	if (_pool_current_worker >= 0) {
+		_pool->workers[_pool_current_worker].queue.push_back(task);
+	} else {
+		_pool->shared_queue.push_back(task);
+	}
+	WakeIdleWorker(_pool->idle);
+	_pool->mutex->EndCritical();
+
+	if (handle != NULL) *handle = std::move(task);
+	return true;
+}
+
+/**
+ * Submit a task to the thread pool.
+ * @param proc The procedure to call inside the thread.
+ * @param param The params to give with 'proc'.
+ * @param handle Place to store the handle of the task in. May be NULL.
+ * @param flags Flags of the task.
+ * @param name A name for the task. May be NULL.
+ * @return True if the task has been submitted, false if there are no threads, in which case the caller should do the work itself.
+ */
+/* static */ bool ThreadPool::Submit(OTTDThreadFunc proc, void *param, ThreadPoolHandle *handle, ThreadPoolTaskFlags flags, const char *name)
+{
+	return ThreadPool::Submit([proc, param]() { proc(param); }, handle, flags, name);
+}
+
+/**
+ * Run a procedure over a range of indices, split in chunks which are spread over the workers.
+ * The calling thread takes part in the work and returns when all chunks are done.
+ * @param count Number of indices.
+ * @param chunk_size Number of indices handed out at once.
+ * @param proc Procedure to call for each chunk, with the first and one past the last index of the chunk.
+ */
+/* static */ void ThreadPool::ParallelFor(size_t count, size_t chunk_size, const std::function<void(size_t, size_t)> &proc)
+{
+	assert(chunk_size > 0);
+	if (count == 0) return;
+
+	size_t chunks = CeilDivT<size_t>(count, chunk_size);
+	uint helpers = (uint)min<size_t>(chunks - 1, ThreadPool::GetWorkerCount());
+
+	ThreadMutex *mutex = (helpers > 0) ? ThreadMutex::New() : NULL;
+	size_t next = 0;
+	auto run_chunks = [&]() {
+		for (;;) {
+			if (mutex != NULL) mutex->BeginCritical();
+			size_t begin = next;
+			next = min(begin + chunk_size, count);
+			if (mutex != NULL) mutex->EndCritical();
+			if (begin >= count) return;
+			proc(begin, min(begin + chunk_size, count));
+		}
+	};
+
+	std::vector<ThreadPoolHandle> tasks(helpers);
+	for (uint i = 0; i < helpers; i++) {
+		if (!ThreadPool::Submit(run_chunks, &tasks[i])) break;
+	}
+	run_chunks();
+	for (ThreadPoolHandle &task : tasks) {
+		if (task) task->Join();
+	}
+	delete mutex;
+}
+
+/**
+ * Forget about the worker threads in a child process created by fork().
+ * Only the forking thread exists in the child, and the pool mutex may have been held by a
+ * worker at the time of the fork, so the child gets a new and empty pool instead.
+ * Tasks submitted afterwards are run by their submitters.
+ */
+/* static */ void ThreadPool::ForgetWorkersAfterFork()
+{
+	/* The old state is leaked on purpose, its mutex may be locked forever. */
+	_pool = new ThreadPoolState();
+	_pool->mutex = ThreadMutex::New();
+	_pool->worker_count = 0;
+	_pool->blocking_worker_count = 0;
+	_pool->shutting_down = false;
+}
+
+/**
+ * Get the number of worker threads of the pool.
+ * @return The number of workers; 0 if there are no threads.
+ */
+/* static */ uint ThreadPool::GetWorkerCount()
+{
+	return (_pool != NULL) ? _pool->worker_count : 0;
+}
+
+/**
+ * Check whether the current thread is one of the workers of the pool.
+ * @return true if the current thread is a worker.
+ */
+/* static */ bool ThreadPool::IsWorkerThread()
+{
+	return _pool_current_worker >= 0;
+}
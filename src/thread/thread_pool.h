@@ -0,0 +1,102 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file thread_pool.h Shared pool of worker threads for background tasks. */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "thread.h"
+#include "../core/enum_type.hpp"
+#include <functional>
+#include <memory>
+
+/** Flags for tasks submitted to the thread pool. */
+enum ThreadPoolTaskFlags {
+	TPTF_NONE     = 0,      ///< Plain computational task.
+	TPTF_BLOCKING = 1 << 0, ///< Task may block for a long time (I/O, waiting for the main thread); it is run by a separate set of threads and never by the joining thread.
+	TPTF_LONG     = 1 << 1, ///< Task computes for a long time; joining it before it has been started waits for a worker instead of running it in the joining thread.
+};
+DECLARE_ENUM_AS_BIT_SET(ThreadPoolTaskFlags)
+
+/**
+ * A task submitted to the thread pool.
+ * The handle can be used to check whether the task has finished and to join it.
+ */
+class ThreadPoolTask {
+	friend class ThreadPool;
+
+	/** State of a task. */
+	enum State {
+		TS_QUEUED,  ///< Waiting in a queue for a worker.
+		TS_RUNNING, ///< Being run by a worker or by the joining thread.
+		TS_DONE,    ///< Finished.
+	};
+
+	std::function<void()> proc; ///< The work to do.
+	ThreadPoolTaskFlags flags;  ///< Flags of the task.
+	const char *name;           ///< Name of the task, for debugging.
+	ThreadMutex *mutex;         ///< Mutex to wait for completion on.
+	State state;                ///< Current state, written under the pool mutex (queued to running) or #mutex (running to done).
+	int queue;                  ///< Queue the task is waiting in: worker index, or -1 for the shared queue.
+
+	void Run();
+	State GetState() const;
+	void SetState(State state);
+
+public:
+	ThreadPoolTask(std::function<void()> proc, ThreadPoolTaskFlags flags, const char *name);
+	~ThreadPoolTask();
+
+	bool IsFinished() const;
+	void Join();
+};
+
+/** Handle to a task in the thread pool. */
+typedef std::shared_ptr<ThreadPoolTask> ThreadPoolHandle;
+
+/**
+ * Fixed size pool of worker threads, sized to the number of processor cores.
+ * Each worker has its own task queue; tasks submitted from a worker go into its own queue,
+ * tasks from other threads into a shared queue. Idle workers steal from the other queues.
+ * Joining a task which has not been started yet runs it in the joining thread, unless it is a long task.
+ * Blocking tasks do not occupy the workers, they are run by a bounded set of blocking workers
+ * which are started on demand.
+ */
+class ThreadPool {
+	static ThreadPoolHandle TakeTask(uint index);
+	static void WorkerProc(void *param);
+	static void BlockingWorkerProc(void *param);
+	static bool StartBlockingWorker();
+
+public:
+	static void Init();
+	static void Shutdown();
+
+	static bool Submit(std::function<void()> proc, ThreadPoolHandle *handle = NULL, ThreadPoolTaskFlags flags = TPTF_NONE, const char *name = NULL);
+	static bool Submit(OTTDThreadFunc proc, void *param, ThreadPoolHandle *handle = NULL, ThreadPoolTaskFlags flags = TPTF_NONE, const char *name = NULL);
+
+	static void ParallelFor(size_t count, size_t chunk_size, const std::function<void(size_t, size_t)> &proc);
+
+	static uint GetWorkerCount();
+	static bool IsWorkerThread();
+
+	static void ForgetWorkersAfterFork();
+
+	/**
+	 * End the current task. Only valid inside a task.
+	 * This is the equivalent of ThreadObject::Exit for tasks.
+	 */
+	static inline void ExitTask()
+	{
+		throw OTTDThreadExitSignal();
+	}
+};
+
+#endif /* THREAD_POOL_H */
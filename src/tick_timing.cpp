@@ -0,0 +1,183 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_timing.cpp Measuring the time spent in the parts of a game tick. */
+
+#include "stdafx.h"
+#include "tick_timing.h"
+#include "core/bitmath_func.hpp"
+#include "core/math_func.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+#include "safeguards.h"
+
+/** Rolling history of the time spent per tick in a single part of the game tick. */
+struct TickTimingHistory {
+	uint64 current;                      ///< Time spent in the tick that is running, in nanoseconds.
+	uint32 samples[TICK_TIMING_HISTORY]; ///< Time spent in the last ticks, in nanoseconds.
+	uint16 buckets[TICK_TIMING_BUCKETS]; ///< Histogram of #samples.
+	uint64 sum;                          ///< Sum of #samples.
+};
+
+/** Totals of all parts of the game tick. */
+static TickTimingTotal _tick_timings[TTP_END];
+/** Histories of all parts of the game tick. */
+static TickTimingHistory _tick_timing_histories[TTP_END];
+/** Index in the histories where the next tick is stored. */
+static uint _tick_timing_pos;
+/** Number of ticks in the histories. */
+static uint _tick_timing_samples;
+
+/** Names of the parts of the game tick, as shown to the user. */
+static const char * const _tick_timing_names[TTP_END] = {
+	"game_loop",
+	"animated_tiles",
+	"tile_loop",
+	"vehicles",
+	"trains",
+	"road_vehicles",
+	"ships",
+	"aircraft",
+	"landscape",
+	"towns",
+	"trees",
+	"stations",
+	"industries",
+	"companies",
+	"link_graph",
+	"ai",
+	"game_script",
+	"drawing",
+};
+
+/**
+ * Get the histogram bucket of a time.
+ * @param time The time, in nanoseconds.
+ * @return The bucket.
+ */
+static uint GetTickTimingBucket(uint32 time)
+{
+	uint32 us = time / 1000;
+	if (us == 0) return 0;
+	return min<uint>(FindLastBit(us) + 1, TICK_TIMING_BUCKETS - 1);
+}
+
+/**
+ * Get the current value of the clock used for the timings.
+ * @return A monotonic time, in nanoseconds.
+ */
+uint64 GetTickTimingClock()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Add the time spent in a part of the game tick.
+ * @param phase The part of the game tick.
+ * @param time The time spent, in nanoseconds.
+ */
+void RecordTickTiming(TickTimingPhase phase, uint64 time)
+{
+	_tick_timings[phase].time += time;
+	_tick_timings[phase].count++;
+	_tick_timing_histories[phase].current += time;
+}
+
+/**
+ * Move the times spent in the tick that just finished into the histories.
+ * Called once per game loop, so parts that did not run get a time of zero.
+ */
+void FinishTickTimings()
+{
+	for (uint i = 0; i < TTP_END; i++) {
+		TickTimingHistory &h = _tick_timing_histories[i];
+		uint32 time = (uint32)min<uint64>(h.current, UINT32_MAX);
+		h.current = 0;
+
+		if (_tick_timing_samples == TICK_TIMING_HISTORY) {
+			uint32 old = h.samples[_tick_timing_pos];
+			h.sum -= old;
+			h.buckets[GetTickTimingBucket(old)]--;
+		}
+		h.samples[_tick_timing_pos] = time;
+		h.sum += time;
+		h.buckets[GetTickTimingBucket(time)]++;
+	}
+
+	_tick_timing_pos = (_tick_timing_pos + 1) % TICK_TIMING_HISTORY;
+	if (_tick_timing_samples < TICK_TIMING_HISTORY) _tick_timing_samples++;
+}
+
+/**
+ * Get the time spent in a part of the game tick since the last reset.
+ * @param phase The part of the game tick.
+ * @return The total time and run count.
+ */
+const TickTimingTotal &GetTickTimingTotal(TickTimingPhase phase)
+{
+	return _tick_timings[phase];
+}
+
+/**
+ * Get the statistics of the time spent per tick in a part of the game tick.
+ * @param phase The part of the game tick.
+ * @param[out] stats The statistics.
+ */
+void GetTickTimingStats(TickTimingPhase phase, TickTimingStats *stats)
+{
+	const TickTimingHistory &h = _tick_timing_histories[phase];
+
+	memset(stats, 0, sizeof(*stats));
+	stats->samples = _tick_timing_samples;
+	memcpy(stats->buckets, h.buckets, sizeof(stats->buckets));
+	if (_tick_timing_samples == 0) return;
+
+	uint32 sorted[TICK_TIMING_HISTORY];
+	memcpy(sorted, h.samples, _tick_timing_samples * sizeof(sorted[0]));
+	std::sort(sorted, sorted + _tick_timing_samples);
+
+	stats->average = (uint32)(h.sum / _tick_timing_samples);
+	stats->median = sorted[_tick_timing_samples / 2];
+	stats->p99 = sorted[_tick_timing_samples * 99 / 100];
+	stats->max = sorted[_tick_timing_samples - 1];
+}
+
+/**
+ * Get the name of a part of the game tick.
+ * @param phase The part of the game tick.
+ * @return The name.
+ */
+const char *GetTickTimingName(TickTimingPhase phase)
+{
+	return _tick_timing_names[phase];
+}
+
+/**
+ * Find a part of the game tick by its name.
+ * @param name The name of the part.
+ * @return The part, or #TTP_END when there is no part with the name.
+ */
+TickTimingPhase GetTickTimingPhaseByName(const char *name)
+{
+	for (uint i = 0; i < TTP_END; i++) {
+		if (strcmp(_tick_timing_names[i], name) == 0) return (TickTimingPhase)i;
+	}
+	return TTP_END;
+}
+
+/** Clear the totals and histories of all parts of the game tick. */
+void ResetTickTimings()
+{
+	memset(_tick_timings, 0, sizeof(_tick_timings));
+	memset(_tick_timing_histories, 0, sizeof(_tick_timing_histories));
+	_tick_timing_pos = 0;
+	_tick_timing_samples = 0;
+}
@@ -0,0 +1,90 @@
+/* $Id$ */
+
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file tick_timing.h Measuring the time spent in the parts of a game tick. */
+
+#ifndef TICK_TIMING_H
+#define TICK_TIMING_H
+
+/**
+ * The parts of a game tick of which the time is measured.
+ * Some parts are contained in the part listed before them, e.g. the
+ * vehicle types are part of the vehicle ticks.
+ */
+enum TickTimingPhase {
+	TTP_GAME_LOOP,      ///< The whole state game loop.
+	TTP_ANIMATED_TILES, ///< Animating tiles.
+	TTP_TILE_LOOP,      ///< The tile loop.
+	TTP_VEHICLES,       ///< Vehicle ticks.
+	TTP_TRAINS,         ///< Ticks of trains.
+	TTP_ROAD_VEHICLES,  ///< Ticks of road vehicles.
+	TTP_SHIPS,          ///< Ticks of ships.
+	TTP_AIRCRAFT,       ///< Ticks of aircraft.
+	TTP_LANDSCAPE,      ///< The landscape tick, i.e. the OnTick_* handlers.
+	TTP_TOWNS,          ///< OnTick_Town.
+	TTP_TREES,          ///< OnTick_Trees.
+	TTP_STATIONS,       ///< OnTick_Station.
+	TTP_INDUSTRIES,     ///< OnTick_Industry.
+	TTP_COMPANIES,      ///< OnTick_Companies.
+	TTP_LINK_GRAPH,     ///< OnTick_LinkGraph, i.e. spawning and joining link graph jobs.
+	TTP_AI,             ///< Running the AIs.
+	TTP_GAME_SCRIPT,    ///< Running the game script.
+	TTP_DRAWING,        ///< Drawing the dirty parts of the screen.
+	TTP_END,            ///< End marker.
+};
+
+/** Number of ticks of which the timings are kept. */
+static const uint TICK_TIMING_HISTORY = 512;
+/** Number of buckets of the timing histograms. Bucket n holds times of less than 2^n microseconds, the last bucket holds all longer times. */
+static const uint TICK_TIMING_BUCKETS = 16;
+
+/** Time spent in a single part of the game tick since the last reset. */
+struct TickTimingTotal {
+	uint64 time;  ///< Total time, in nanoseconds.
+	uint32 count; ///< Number of times the part has been run.
+};
+
+/** Statistics of the time spent per tick in a single part of the game tick, over the last #TICK_TIMING_HISTORY ticks. */
+struct TickTimingStats {
+	uint samples;                        ///< Number of ticks the statistics are about.
+	uint32 average;                      ///< Average time per tick, in nanoseconds.
+	uint32 median;                       ///< Median time per tick, in nanoseconds.
+	uint32 p99;                          ///< 99th percentile of the time per tick, in nanoseconds.
+	uint32 max;                          ///< Maximum time per tick, in nanoseconds.
+	uint16 buckets[TICK_TIMING_BUCKETS]; ///< Histogram of the time per tick.
+};
+
+uint64 GetTickTimingClock();
+void RecordTickTiming(TickTimingPhase phase, uint64 time);
+void FinishTickTimings();
+const TickTimingTotal &GetTickTimingTotal(TickTimingPhase phase);
+void GetTickTimingStats(TickTimingPhase phase, TickTimingStats *stats);
+const char *GetTickTimingName(TickTimingPhase phase);
+TickTimingPhase GetTickTimingPhaseByName(const char *name);
+void ResetTickTimings();
+
+/** Measures the time spent in a part of the game tick while it is in scope. */
+class TickTimer {
+	TickTimingPhase phase; ///< The part that is measured.
+	uint64 start;          ///< Clock value when the measurement started.
+
+public:
+	/**
+	 * Start measuring a part of the game tick.
+	 * @param phase The part to measure.
+	 */
+	TickTimer(TickTimingPhase phase) : phase(phase), start(GetTickTimingClock()) {}
+
+	~TickTimer()
+	{
+		RecordTickTiming(this->phase, GetTickTimingClock() - this->start);
+	}
+};
+
+#endif /* TICK_TIMING_H */
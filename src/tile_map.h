@@ -31,7 +31,7 @@
 static inline uint TileHeight(TileIndex tile)
 {
 	assert_msg(tile < MapSize(), "tile: 0x%X, size: 0x%X", tile, MapSize());
-	return _m[tile].height;
+	return _mth[tile].height;
 }
 
 uint TileHeightOutsideMap(int x, int y);
@@ -50,7 +50,7 @@ static inline void SetTileHeight(TileIndex tile, uint height)
 {
 	assert_msg(tile < MapSize(), "tile: 0x%X, size: 0x%X", tile, MapSize());
 	assert(height <= MAX_TILE_HEIGHT);
-	_m[tile].height = height;
+	_mth[tile].height = height;
 }
 
 /**
@@ -89,7 +89,7 @@ static inline uint TilePixelHeightOutsideMap(int x, int y)
 static inline TileType GetTileType(TileIndex tile)
 {
 	assert_msg(tile < MapSize(), "tile: 0x%X, size: 0x%X", tile, MapSize());
-	return (TileType)GB(_m[tile].type, 4, 4);
+	return (TileType)GB(_mth[tile].type, 4, 4);
 }
 
 /**
@@ -128,7 +128,7 @@ static inline void SetTileType(TileIndex tile, TileType type)
 	 * edges of the map. If _settings_game.construction.freeform_edges is true,
 	 * the upper edges of the map are also VOID tiles. */
 	assert_msg(IsInnerTile(tile) == (type != MP_VOID), "tile: 0x%X (%d), type: %d", tile, IsInnerTile(tile), type);
-	SB(_m[tile].type, 4, 4, type);
+	SB(_mth[tile].type, 4, 4, type);
 }
 
 /**
@@ -217,7 +217,7 @@ static inline void SetTropicZone(TileIndex tile, TropicZone type)
 {
 	assert_msg(tile < MapSize(), "tile: 0x%X, size: 0x%X, type: %d", tile, MapSize(), type);
 	assert_msg(!IsTileType(tile, MP_VOID) || type == TROPICZONE_NORMAL, "tile: 0x%X (%d), type: %d", tile, GetTileType(tile), type);
-	SB(_m[tile].type, 0, 2, type);
+	SB(_mth[tile].type, 0, 2, type);
 }
 
 /**
@@ -229,7 +229,7 @@ static inline void SetTropicZone(TileIndex tile, TropicZone type)
 static inline TropicZone GetTropicZone(TileIndex tile)
 {
 	assert_msg(tile < MapSize(), "tile: 0x%X, size: 0x%X", tile, MapSize());
-	return (TropicZone)GB(_m[tile].type, 0, 2);
+	return (TropicZone)GB(_mth[tile].type, 0, 2);
 }
 
 /**
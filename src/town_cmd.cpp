@@ -46,6 +46,7 @@
 #include "ai/ai.hpp"
 #include "game/game.hpp"
 #include "zoom_func.h"
+#include "tick_timing.h"
 
 #include "table/strings.h"
 #include "table/town_land.h"
@@ -954,6 +955,8 @@ static void TownTickHandler(Town *t)
 
 void OnTick_Town()
 {
+	TickTimer timer(TTP_TOWNS);
+
 	if (_game_mode == GM_EDITOR) return;
 
 	Town *t;
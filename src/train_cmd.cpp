@@ -41,6 +41,7 @@
 #include "autoreplace_func.h"
 #include "engine_func.h"
 #include "bridge_signal_map.h"
+#include "tick_timing.h"
 
 #include "table/strings.h"
 #include "table/train_cmd.h"
@@ -4620,6 +4621,8 @@ bool Train::Tick()
 	this->tick_counter++;
 
 	if (this->IsFrontEngine()) {
+		TickTimer timer(TTP_TRAINS);
+
 		if (!(this->vehstatus & VS_STOPPED) || this->cur_speed > 0) this->running_ticks++;
 
 		this->current_order_time++;
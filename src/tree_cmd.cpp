@@ -24,6 +24,8 @@
 #include "company_base.h"
 #include "core/random_func.hpp"
 #include "newgrf_generic.h"
+#include "pathfinder/water_regions.h"
+#include "tick_timing.h"
 
 #include "table/strings.h"
 #include "table/tree_land.h"
@@ -824,7 +826,7 @@ static void TileLoop_Trees(TileIndex tile)
 			} else {
 				/* just one tree, change type into MP_CLEAR */
 				switch (GetTreeGround(tile)) {
-					case TREE_GROUND_SHORE: MakeShore(tile); break;
+					case TREE_GROUND_SHORE: MakeShore(tile); InvalidateWaterRegion(tile); break;
 					case TREE_GROUND_GRASS: MakeClear(tile, CLEAR_GRASS, GetTreeDensity(tile)); break;
 					case TREE_GROUND_ROUGH: MakeClear(tile, CLEAR_ROUGH, 3); break;
 					case TREE_GROUND_ROUGH_SNOW: {
@@ -856,6 +858,8 @@ static void TileLoop_Trees(TileIndex tile)
 
 void OnTick_Trees()
 {
+	TickTimer timer(TTP_TREES);
+
 	/* Don't place trees if that's not allowed */
 	if (_settings_game.construction.extra_tree_placement == ETP_NONE) return;
 
@@ -46,6 +46,7 @@
 #include "viewport_func.h"
 #include "station_map.h"
 #include "industry_map.h"
+#include "pathfinder/water_regions.h"
 
 #include "table/strings.h"
 #include "table/bridge_land.h"
@@ -557,6 +558,8 @@ CommandCost CmdBuildBridge(TileIndex end_tile, DoCommandFlag flags, uint32 p1, u
 				if (is_new_owner && c != NULL) c->infrastructure.water += (bridge_len + 2) * TUNNELBRIDGE_TRACKBIT_FACTOR;
 				MakeAqueductBridgeRamp(tile_start, owner, dir);
 				MakeAqueductBridgeRamp(tile_end,   owner, ReverseDiagDir(dir));
+				InvalidateWaterRegion(tile_start);
+				InvalidateWaterRegion(tile_end);
 				break;
 
 			default:
@@ -58,6 +58,7 @@
 #include "tbtr_template_vehicle_func.h"
 #include "string_func.h"
 #include "scope_info.h"
+#include "tick_timing.h"
 #include "3rdparty/cpp-btree/btree_set.h"
 
 #include "table/strings.h"
@@ -392,32 +393,100 @@ byte VehicleRandomBits()
 	return GB(Random(), 0, 8);
 }
 
-/* Size of the hash, 6 = 64 x 64, 7 = 128 x 128. Larger sizes will (in theory) reduce hash
- * lookup times at the expense of memory usage. */
-const int HASH_BITS = 7;
-const int HASH_SIZE = 1 << HASH_BITS;
-const int HASH_MASK = HASH_SIZE - 1;
-const int TOTAL_HASH_SIZE = 1 << (HASH_BITS * 2);
-const int TOTAL_HASH_MASK = TOTAL_HASH_SIZE - 1;
+/*
+ * The vehicle tile hash is a grid of buckets laid over the map, so tiles far apart never share a bucket.
+ * Up to 2^MAX_VEHICLE_TILE_HASH_BITS tiles there is one bucket per tile; on larger maps a bucket
+ * covers a small block of neighbouring tiles, to limit the memory usage.
+ */
+static const uint MAX_VEHICLE_TILE_HASH_BITS = 20;
 
-/* Resolution of the hash, 0 = 1*1 tile, 1 = 2*2 tiles, 2 = 4*4 tiles, etc.
- * Profiling results show that 0 is fastest. */
-const int HASH_RES = 0;
+static Vehicle **_vehicle_tile_hash = NULL;      ///< Buckets of the vehicle tile hash, the first vehicle in each bucket.
+static uint64 *_vehicle_tile_hash_used = NULL;   ///< Bitmap of the buckets of the vehicle tile hash which are not empty.
+static uint _vehicle_tile_hash_size = 0;         ///< Number of buckets of the vehicle tile hash.
+static uint _vehicle_tile_hash_shift_x = 0;      ///< Number of bits of a tile's X coordinate ignored by the vehicle tile hash.
+static uint _vehicle_tile_hash_shift_y = 0;      ///< Number of bits of a tile's Y coordinate ignored by the vehicle tile hash.
+static uint _vehicle_tile_hash_log_x = 0;        ///< Logarithm of the number of buckets along the X axis of the vehicle tile hash.
 
-static Vehicle *_vehicle_tile_hash[TOTAL_HASH_SIZE];
+/**
+ * Get the vehicle tile hash bucket of a tile.
+ * Vehicles can be outside of the map (e.g. disaster vehicles), so the
+ * coordinates are clamped to the map's edges.
+ * @param x X coordinate of the tile.
+ * @param y Y coordinate of the tile.
+ * @return Index of the bucket.
+ */
+static inline uint GetVehicleTileHashBucket(uint x, uint y)
+{
+	x = min(x, MapMaxX());
+	y = min(y, MapMaxY());
+	uint bucket = ((y >> _vehicle_tile_hash_shift_y) << _vehicle_tile_hash_log_x) | (x >> _vehicle_tile_hash_shift_x);
+	assert(bucket < _vehicle_tile_hash_size);
+	return bucket;
+}
 
-static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, void *data, VehicleFromPosProc *proc, bool find_first)
+/**
+ * Check whether a bucket of the vehicle tile hash contains any vehicles.
+ * @param bucket Index of the bucket.
+ * @return True if there are no vehicles in the bucket.
+ */
+static inline bool IsVehicleTileHashBucketEmpty(uint bucket)
 {
-	for (int y = yl; ; y = (y + (1 << HASH_BITS)) & (HASH_MASK << HASH_BITS)) {
-		for (int x = xl; ; x = (x + 1) & HASH_MASK) {
-			Vehicle *v = _vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
-			for (; v != NULL; v = v->hash_tile_next) {
+	return !HasBit(_vehicle_tile_hash_used[bucket / 64], bucket % 64);
+}
+
+/**
+ * (Re)allocate the vehicle tile hash for the current map size.
+ * All vehicles are removed from the hash.
+ */
+void AllocateVehicleTileHash()
+{
+	uint log_x = MapLogX();
+	uint log_y = MapLogY();
+	while (log_x + log_y > MAX_VEHICLE_TILE_HASH_BITS) {
+		if (log_x >= log_y) {
+			log_x--;
+		} else {
+			log_y--;
+		}
+	}
+
+	_vehicle_tile_hash_shift_x = MapLogX() - log_x;
+	_vehicle_tile_hash_shift_y = MapLogY() - log_y;
+	_vehicle_tile_hash_log_x = log_x;
+	_vehicle_tile_hash_size = 1 << (log_x + log_y);
+
+	free(_vehicle_tile_hash);
+	free(_vehicle_tile_hash_used);
+	_vehicle_tile_hash = CallocT<Vehicle *>(_vehicle_tile_hash_size);
+	_vehicle_tile_hash_used = CallocT<uint64>(CeilDiv(_vehicle_tile_hash_size, 64));
+
+	Vehicle *v;
+	FOR_ALL_VEHICLES(v) { v->hash_tile_current = NULL; }
+}
+
+/**
+ * Call a proc for all vehicles in a rectangle of buckets of the vehicle tile hash.
+ * @param xl Lowest X coordinate of the buckets.
+ * @param yl Lowest Y coordinate of the buckets.
+ * @param xu Highest X coordinate of the buckets.
+ * @param yu Highest Y coordinate of the buckets.
+ * @param data Arbitrary data passed to proc.
+ * @param proc The proc that determines whether a vehicle will be "found".
+ * @param find_first Whether to return on the first found or iterate over all vehicles.
+ * @return the best matching or first vehicle (depending on find_first).
+ */
+static Vehicle *VehicleFromTileHash(uint xl, uint yl, uint xu, uint yu, void *data, VehicleFromPosProc *proc, bool find_first)
+{
+	for (uint y = yl; y <= yu; y++) {
+		for (uint x = xl; x <= xu; x++) {
+			uint bucket = (y << _vehicle_tile_hash_log_x) | x;
+			if (IsVehicleTileHashBucketEmpty(bucket)) continue;
+
+			for (Vehicle *v = _vehicle_tile_hash[bucket]; v != NULL; v = v->hash_tile_next) {
 				Vehicle *a = proc(v, data);
 				if (find_first && a != NULL) return a;
 			}
-			if (x == xu) break;
 		}
-		if (y == yu) break;
 	}
 
 	return NULL;
@@ -440,10 +509,10 @@ static Vehicle *VehicleFromPosXY(int x, int y, void *data, VehicleFromPosProc *p
 	const int COLL_DIST = 6;
 
 	/* Hash area to scan is from xl,yl to xu,yu */
-	int xl = GB((x - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int xu = GB((x + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int yl = GB((y - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
-	int yu = GB((y + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
+	uint xl = Clamp((x - COLL_DIST) / (int)TILE_SIZE, 0, (int)MapMaxX()) >> _vehicle_tile_hash_shift_x;
+	uint xu = Clamp((x + COLL_DIST) / (int)TILE_SIZE, 0, (int)MapMaxX()) >> _vehicle_tile_hash_shift_x;
+	uint yl = Clamp((y - COLL_DIST) / (int)TILE_SIZE, 0, (int)MapMaxY()) >> _vehicle_tile_hash_shift_y;
+	uint yu = Clamp((y + COLL_DIST) / (int)TILE_SIZE, 0, (int)MapMaxY()) >> _vehicle_tile_hash_shift_y;
 
 	return VehicleFromTileHash(xl, yl, xu, yu, data, proc, find_first);
 }
@@ -495,10 +564,10 @@ bool HasVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc)
  */
 static Vehicle *VehicleFromPos(TileIndex tile, void *data, VehicleFromPosProc *proc, bool find_first)
 {
-	int x = GB(TileX(tile), HASH_RES, HASH_BITS);
-	int y = GB(TileY(tile), HASH_RES, HASH_BITS) << HASH_BITS;
+	uint bucket = GetVehicleTileHashBucket(TileX(tile), TileY(tile));
+	if (IsVehicleTileHashBucketEmpty(bucket)) return NULL;
 
-	Vehicle *v = _vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
+	Vehicle *v = _vehicle_tile_hash[bucket];
 	for (; v != NULL; v = v->hash_tile_next) {
 		if (v->tile != tile) continue;
 
@@ -678,9 +747,7 @@ static void UpdateVehicleTileHash(Vehicle *v, bool remove)
 	if (remove) {
 		new_hash = NULL;
 	} else {
-		int x = GB(TileX(v->tile), HASH_RES, HASH_BITS);
-		int y = GB(TileY(v->tile), HASH_RES, HASH_BITS) << HASH_BITS;
-		new_hash = &_vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
+		new_hash = &_vehicle_tile_hash[GetVehicleTileHashBucket(TileX(v->tile), TileY(v->tile))];
 	}
 
 	if (old_hash == new_hash) return;
@@ -689,6 +756,11 @@ static void UpdateVehicleTileHash(Vehicle *v, bool remove)
 	if (old_hash != NULL) {
 		if (v->hash_tile_next != NULL) v->hash_tile_next->hash_tile_prev = v->hash_tile_prev;
 		*v->hash_tile_prev = v->hash_tile_next;
+
+		if (*old_hash == NULL) {
+			uint bucket = old_hash - _vehicle_tile_hash;
+			ClrBit(_vehicle_tile_hash_used[bucket / 64], bucket % 64);
+		}
 	}
 
 	/* Insert vehicle at beginning of the new position in the hash table */
@@ -697,6 +769,9 @@ static void UpdateVehicleTileHash(Vehicle *v, bool remove)
 		if (v->hash_tile_next != NULL) v->hash_tile_next->hash_tile_prev = &v->hash_tile_next;
 		v->hash_tile_prev = new_hash;
 		*new_hash = v;
+
+		uint bucket = new_hash - _vehicle_tile_hash;
+		SetBit(_vehicle_tile_hash_used[bucket / 64], bucket % 64);
 	}
 
 	/* Remember current hash position */
@@ -736,7 +811,8 @@ void ResetVehicleHash()
 	Vehicle *v;
 	FOR_ALL_VEHICLES(v) { v->hash_tile_current = NULL; }
 	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
-	memset(_vehicle_tile_hash, 0, sizeof(_vehicle_tile_hash));
+	MemSetT(_vehicle_tile_hash, 0, _vehicle_tile_hash_size);
+	MemSetT(_vehicle_tile_hash_used, 0, CeilDiv(_vehicle_tile_hash_size, 64));
 }
 
 void ResetVehicleColourMap()
@@ -1059,12 +1135,17 @@ static void ShowAutoReplaceAdviceMessage(const CommandCost &res, const Vehicle *
 
 void CallVehicleTicks()
 {
+	TickTimer timer(TTP_VEHICLES);
+
 	_vehicles_to_autoreplace.Clear();
 	_vehicles_to_templatereplace.Clear();
 	_vehicles_to_pay_repair.clear();
 
 	if (_tick_skip_counter == 0) RunVehicleDayProc();
 
+	/* This stays serial: loading and unloading allocates cargo packets from the pool,
+	 * runs NewGRF callbacks and triggers, and pays and refreshes links for shared
+	 * companies and link graphs. None of that may run concurrently. */
 	Station *st;
 	FOR_ALL_STATIONS(st) LoadUnloadStation(st);
 
@@ -53,6 +53,7 @@ void VehicleLengthChanged(const Vehicle *u);
 
 byte VehicleRandomBits();
 void ResetVehicleHash();
+void AllocateVehicleTileHash();
 void ResetVehicleColourMap();
 
 byte GetBestFittingSubType(Vehicle *v_from, Vehicle *v_for, CargoID dest_cargo_type);
@@ -100,12 +100,21 @@
 #include "tunnelbridge_map.h"
 #include "gui.h"
 #include "core/container_func.hpp"
+#include "newgrf_debug.h"
+#include "spritecache.h"
+#include "thread/thread_pool.h"
+#include "date_func.h"
+#include "debug.h"
 
 #include <map>
 #include <vector>
 #include <math.h>
 #include <algorithm>
 #include <tuple>
+#include <unordered_map>
+#include <queue>
+#include <functional>
+#include <list>
 
 #include "table/strings.h"
 #include "table/string_colours.h"
@@ -222,6 +231,9 @@ struct ViewportDrawer {
 	FoundationPart foundation_part;                  ///< Currently active foundation for ground sprite drawing.
 	int *last_foundation_child[FOUNDATION_PART_END]; ///< Tail of ChildSprite list of the foundations. (index into child_screen_sprites_to_draw)
 	Point foundation_offset[FOUNDATION_PART_END];    ///< Pixel offset for ground sprites on the foundations.
+
+	bool recording_tile;                             ///< The sprites of a tile are recorded for the tile sprite cache, they are culled when replayed instead.
+	std::vector<Rect> recorded_parent_extents;       ///< Screen extents of the parent sprites added while recording a tile.
 };
 
 static void MarkViewportDirty(const ViewPort * const vp, int left, int top, int right, int bottom);
@@ -760,11 +772,19 @@ static void AddCombinedSprite(SpriteID image, PaletteID pal, int x, int y, int z
 	Point pt = RemapCoords(x, y, z);
 	const Sprite *spr = GetSprite(image & SPRITE_MASK, ST_NORMAL);
 
-	if (pt.x + spr->x_offs >= _vd.dpi.left + _vd.dpi.width ||
+	if (_vd.recording_tile) {
+		/* The combined sprites are culled together with their parent sprite. */
+		Rect &extent = _vd.recorded_parent_extents.back();
+		extent.left   = min<int>(extent.left,   pt.x + spr->x_offs);
+		extent.right  = max<int>(extent.right,  pt.x + spr->x_offs + spr->width);
+		extent.top    = min<int>(extent.top,    pt.y + spr->y_offs);
+		extent.bottom = max<int>(extent.bottom, pt.y + spr->y_offs + spr->height);
+	} else if (pt.x + spr->x_offs >= _vd.dpi.left + _vd.dpi.width ||
 			pt.x + spr->x_offs + spr->width <= _vd.dpi.left ||
 			pt.y + spr->y_offs >= _vd.dpi.top + _vd.dpi.height ||
-			pt.y + spr->y_offs + spr->height <= _vd.dpi.top)
+			pt.y + spr->y_offs + spr->height <= _vd.dpi.top) {
 		return;
+	}
 
 	const ParentSpriteToDraw *pstd = _vd.parent_sprites_to_draw.End() - 1;
 	AddChildSpriteScreen(image, pal, pt.x - pstd->left, pt.y - pstd->top, false, sub, false);
@@ -839,11 +859,15 @@ void AddSortableSpriteToDraw(SpriteID image, PaletteID pal, int x, int y, int w,
 		bottom = max(bottom, RemapCoords(x + w          , y + h          , z + bb_offset_z).y + 1);
 	}
 
-	/* Do not add the sprite to the viewport, if it is outside */
-	if (left   >= _vd.dpi.left + _vd.dpi.width ||
-	    right  <= _vd.dpi.left                 ||
-	    top    >= _vd.dpi.top + _vd.dpi.height ||
-	    bottom <= _vd.dpi.top) {
+	if (_vd.recording_tile) {
+		/* The sprite is culled when the recorded tile is added to the viewport. */
+		Rect extent = { left, top, right, bottom };
+		_vd.recorded_parent_extents.push_back(extent);
+	} else if (left   >= _vd.dpi.left + _vd.dpi.width ||
+	           right  <= _vd.dpi.left                 ||
+	           top    >= _vd.dpi.top + _vd.dpi.height ||
+	           bottom <= _vd.dpi.top) {
+		/* Do not add the sprite to the viewport, if it is outside */
 		return;
 	}
 
@@ -1191,6 +1215,261 @@ static int GetViewportY(Point tile)
 	return (tile.y * (int)(TILE_PIXELS / 2) + tile.x * (int)(TILE_PIXELS / 2) - TilePixelHeightOutsideMap(tile.x, tile.y)) << ZOOM_LVL_SHIFT;
 }
 
+/** Sprites added by the draw tile proc of a single tile at one zoom level, see #ViewportDrawTileCached. */
+struct ViewportTileSpriteCacheEntry {
+	ZoomLevel zoom;                                     ///< Zoom level the sprites were resolved for.
+	uint32 generation;                                  ///< Value of #_vp_tile_sprite_cache_generation when the sprites were resolved.
+	Date date;                                          ///< Date the sprites were resolved, time dependent graphics are resolved again each day.
+	int foundation[FOUNDATION_PART_END];                ///< Foundation sprites (index into parent_sprites), or -1.
+	std::vector<TileSpriteToDraw> tile_sprites;         ///< Ground sprites of the tile.
+	std::vector<ParentSpriteToDraw> parent_sprites;     ///< Parent sprites of the tile, first_child is an index into child_sprites.
+	std::vector<Rect> parent_extents;                   ///< Screen extents of the parent sprites, including combined sprites.
+	std::vector<ChildScreenSpriteToDraw> child_sprites; ///< Child sprites of the tile, next is an index into child_sprites.
+};
+
+/** Cached sprites of a single tile, see #_vp_tile_sprite_cache. */
+struct ViewportTileSpriteCacheTile {
+	std::vector<ViewportTileSpriteCacheEntry> entries; ///< Entries of the tile, one per zoom level it has been drawn at.
+	std::list<TileIndex>::iterator lru;                 ///< Position of the tile in #_vp_tile_sprite_cache_lru.
+};
+
+/** Maximum number of entries in the tile sprite cache; beyond that the least recently drawn tiles are evicted. */
+static const uint VIEWPORT_TILE_SPRITE_CACHE_MAX_ENTRIES = 1 << 18;
+/** Number of entries evicted at once when the tile sprite cache is full. */
+static const uint VIEWPORT_TILE_SPRITE_CACHE_EVICT_ENTRIES = VIEWPORT_TILE_SPRITE_CACHE_MAX_ENTRIES / 16;
+/**
+ * Maximum number of tiles of a single viewport draw going through the tile sprite cache.
+ * Further tiles are drawn directly, so a view showing more tiles than the cache holds does not evict its own tiles again and again.
+ */
+static const uint VIEWPORT_TILE_SPRITE_CACHE_DRAW_LIMIT = VIEWPORT_TILE_SPRITE_CACHE_MAX_ENTRIES - VIEWPORT_TILE_SPRITE_CACHE_EVICT_ENTRIES;
+
+static std::unordered_map<TileIndex, ViewportTileSpriteCacheTile> _vp_tile_sprite_cache; ///< Resolved sprites of each tile, per zoom level.
+static std::list<TileIndex> _vp_tile_sprite_cache_lru; ///< Tiles in #_vp_tile_sprite_cache, most recently drawn first.
+static uint _vp_tile_sprite_cache_entries = 0;     ///< Number of entries in #_vp_tile_sprite_cache.
+static uint32 _vp_tile_sprite_cache_generation = 0; ///< Incremented whenever all cached tile sprites become invalid.
+
+/** Remove all tiles from the tile sprite cache, for example when a new map is allocated. */
+void ClearViewportTileSpriteCache()
+{
+	_vp_tile_sprite_cache.clear();
+	_vp_tile_sprite_cache_lru.clear();
+	_vp_tile_sprite_cache_entries = 0;
+}
+
+/**
+ * Remove a tile from the tile sprite cache.
+ * @param it The tile to remove.
+ */
+static void EraseViewportTileSprites(std::unordered_map<TileIndex, ViewportTileSpriteCacheTile>::iterator it)
+{
+	_vp_tile_sprite_cache_entries -= (uint)it->second.entries.size();
+	_vp_tile_sprite_cache_lru.erase(it->second.lru);
+	_vp_tile_sprite_cache.erase(it);
+}
+
+/** Make room in the full tile sprite cache by removing the tiles which have not been drawn for the longest time. */
+static void EvictViewportTileSprites()
+{
+	while (_vp_tile_sprite_cache_entries > VIEWPORT_TILE_SPRITE_CACHE_MAX_ENTRIES - VIEWPORT_TILE_SPRITE_CACHE_EVICT_ENTRIES) {
+		EraseViewportTileSprites(_vp_tile_sprite_cache.find(_vp_tile_sprite_cache_lru.back()));
+	}
+}
+
+/** Mark the cached sprites of all tiles as stale, for example because transparency or display options changed. */
+void InvalidateViewportTileSpriteCache()
+{
+	_vp_tile_sprite_cache_generation++;
+}
+
+/**
+ * Remove a changed tile and its neighbours from the tile sprite cache.
+ * The neighbours are included as fences, catenary, coasts and the like depend on them.
+ * NewGRF graphics can look at tiles up to 8 tiles away; those are not removed here, as this is called for every
+ * dirty tile, including animated ones. Such sprites are instead resolved again each day, see #ViewportDrawTileCached.
+ * This only affects what is drawn, never the game state.
+ * @param tile The tile which changed.
+ */
+static void InvalidateViewportTileSprites(TileIndex tile)
+{
+	if (_vp_tile_sprite_cache_entries == 0) return;
+
+	const uint x = TileX(tile);
+	const uint y = TileY(tile);
+	for (uint ty = max<uint>(y, 1) - 1; ty <= min(y + 1, MapMaxY()); ty++) {
+		for (uint tx = max<uint>(x, 1) - 1; tx <= min(x + 1, MapMaxX()); tx++) {
+			auto it = _vp_tile_sprite_cache.find(TileXY(tx, ty));
+			if (it != _vp_tile_sprite_cache.end()) EraseViewportTileSprites(it);
+		}
+	}
+}
+
+/**
+ * Can the sprites of a tile be cached?
+ * @param ti The tile to draw.
+ * @param tile_type The type of the tile.
+ * @return True if the draw tile proc only depends on data which marks the tile dirty when changed.
+ */
+static bool ViewportIsTileSpriteCacheable(const TileInfo *ti, TileType tile_type)
+{
+	if (ti->tile == INVALID_TILE) return false;
+
+	/* NewGRF stations can show waiting cargo and vehicles, which do not mark the tile dirty. */
+	if (tile_type == MP_STATION && IsCustomStationSpecIndex(ti->tile)) return false;
+
+	return true;
+}
+
+/**
+ * Run the draw tile proc of a tile and move the sprites it adds into a tile sprite cache entry.
+ * Culling by the viewport bounds is disabled while recording, so the entry can be reused for any viewport area.
+ * @param ti The tile to draw.
+ * @param tile_type The type of the tile.
+ * @param entry The entry to fill.
+ */
+static void ViewportRecordTileSprites(TileInfo *ti, TileType tile_type, ViewportTileSpriteCacheEntry &entry)
+{
+	const uint tile_begin = _vd.tile_sprites_to_draw.Length();
+	const uint parent_begin = _vd.parent_sprites_to_draw.Length();
+	const uint child_begin = _vd.child_screen_sprites_to_draw.Length();
+
+	_vd.last_child = NULL;
+	_vd.recording_tile = true;
+	_vd.recorded_parent_extents.clear();
+	_tile_type_procs[tile_type]->draw_tile_proc(ti);
+	_vd.recording_tile = false;
+
+	entry.tile_sprites.assign(_vd.tile_sprites_to_draw.Get(tile_begin), _vd.tile_sprites_to_draw.End());
+	entry.parent_sprites.assign(_vd.parent_sprites_to_draw.Get(parent_begin), _vd.parent_sprites_to_draw.End());
+	entry.child_sprites.assign(_vd.child_screen_sprites_to_draw.Get(child_begin), _vd.child_screen_sprites_to_draw.End());
+	entry.parent_extents.swap(_vd.recorded_parent_extents);
+	assert(entry.parent_extents.size() == entry.parent_sprites.size());
+
+	for (uint i = 0; i < entry.parent_sprites.size(); i++) {
+		if (entry.parent_sprites[i].first_child != -1) entry.parent_sprites[i].first_child -= child_begin;
+	}
+	for (uint i = 0; i < entry.child_sprites.size(); i++) {
+		if (entry.child_sprites[i].next != -1) entry.child_sprites[i].next -= child_begin;
+	}
+	for (uint i = 0; i < FOUNDATION_PART_END; i++) {
+		entry.foundation[i] = _vd.foundation[i] >= (int)parent_begin ? _vd.foundation[i] - parent_begin : -1;
+	}
+
+	_vd.tile_sprites_to_draw.Resize(tile_begin);
+	_vd.parent_sprites_to_draw.Resize(parent_begin);
+	_vd.child_screen_sprites_to_draw.Resize(child_begin);
+}
+
+/**
+ * Add the sprites of a tile sprite cache entry to the viewport, culling the parent sprites outside the viewport bounds.
+ * Afterwards the foundation state is the same as if the draw tile proc had just been called, so the tile selection can be drawn on top.
+ * @param entry The entry to add.
+ */
+static void ViewportAddCachedTileSprites(const ViewportTileSpriteCacheEntry &entry)
+{
+	if (!entry.tile_sprites.empty()) {
+		MemCpyT(_vd.tile_sprites_to_draw.Append((uint)entry.tile_sprites.size()), entry.tile_sprites.data(), entry.tile_sprites.size());
+	}
+
+	for (uint part = 0; part < FOUNDATION_PART_END; part++) _vd.foundation[part] = -1;
+
+	for (uint i = 0; i < entry.parent_sprites.size(); i++) {
+		const Rect &extent = entry.parent_extents[i];
+		if (extent.left   >= _vd.dpi.left + _vd.dpi.width ||
+		    extent.right  <= _vd.dpi.left                 ||
+		    extent.top    >= _vd.dpi.top + _vd.dpi.height ||
+		    extent.bottom <= _vd.dpi.top) {
+			continue;
+		}
+
+		/* The parent sprites are copied as the sorter modifies them. */
+		ParentSpriteToDraw *ps = _vd.parent_sprites_to_draw.Append();
+		*ps = entry.parent_sprites[i];
+		ps->comparison_done = false;
+
+		/* Only the children of parents which are drawn are needed. */
+		ps->first_child = -1;
+		int last = -1;
+		for (int child = entry.parent_sprites[i].first_child; child != -1; child = entry.child_sprites[child].next) {
+			const int index = _vd.child_screen_sprites_to_draw.Length();
+			ChildScreenSpriteToDraw *cs = _vd.child_screen_sprites_to_draw.Append();
+			*cs = entry.child_sprites[child];
+			cs->next = -1;
+			if (last == -1) {
+				ps->first_child = index;
+			} else {
+				_vd.child_screen_sprites_to_draw.Get(last)->next = index;
+			}
+			last = index;
+		}
+
+		for (uint part = 0; part < FOUNDATION_PART_END; part++) {
+			if (entry.foundation[part] == (int)i) _vd.foundation[part] = _vd.parent_sprites_to_draw.Length() - 1;
+		}
+	}
+
+	/* Point the foundation child lists at their tails, now that no more sprites are appended. */
+	for (uint part = 0; part < FOUNDATION_PART_END; part++) {
+		if (_vd.foundation[part] == -1) {
+			_vd.last_foundation_child[part] = NULL;
+			continue;
+		}
+		int *tail = &_vd.parent_sprites_to_draw.Get(_vd.foundation[part])->first_child;
+		while (*tail != -1) tail = &_vd.child_screen_sprites_to_draw.Get(*tail)->next;
+		_vd.last_foundation_child[part] = tail;
+	}
+
+	_vd.last_child = NULL;
+}
+
+/**
+ * Draw a tile using the tile sprite cache, resolving its sprites only if they are not cached yet.
+ * @param ti The tile to draw.
+ * @param tile_type The type of the tile.
+ */
+static void ViewportDrawTileCached(TileInfo *ti, TileType tile_type)
+{
+	if (_vp_tile_sprite_cache_entries >= VIEWPORT_TILE_SPRITE_CACHE_MAX_ENTRIES) EvictViewportTileSprites();
+
+	ViewportTileSpriteCacheTile *cached;
+	auto it = _vp_tile_sprite_cache.find(ti->tile);
+	if (it != _vp_tile_sprite_cache.end()) {
+		cached = &it->second;
+		if (cached->lru != _vp_tile_sprite_cache_lru.begin()) {
+			_vp_tile_sprite_cache_lru.splice(_vp_tile_sprite_cache_lru.begin(), _vp_tile_sprite_cache_lru, cached->lru);
+		}
+	} else {
+		cached = &_vp_tile_sprite_cache[ti->tile];
+		_vp_tile_sprite_cache_lru.push_front(ti->tile);
+		cached->lru = _vp_tile_sprite_cache_lru.begin();
+	}
+
+	std::vector<ViewportTileSpriteCacheEntry> &entries = cached->entries;
+	ViewportTileSpriteCacheEntry *entry = NULL;
+	for (uint i = 0; i < entries.size(); i++) {
+		if (entries[i].zoom == _vd.dpi.zoom) {
+			entry = &entries[i];
+			break;
+		}
+	}
+	if (entry == NULL) {
+		entries.emplace_back();
+		entry = &entries.back();
+		entry->zoom = _vd.dpi.zoom;
+		entry->generation = _vp_tile_sprite_cache_generation - 1;
+		_vp_tile_sprite_cache_entries++;
+	}
+
+	/* Resolving the sprites again each day also bounds how long graphics depending on tiles further
+	 * away than #InvalidateViewportTileSprites covers can be out of date. */
+	if (entry->generation != _vp_tile_sprite_cache_generation || entry->date != _date) {
+		ViewportRecordTileSprites(ti, tile_type, *entry);
+		entry->generation = _vp_tile_sprite_cache_generation;
+		entry->date = _date;
+	}
+
+	ViewportAddCachedTileSprites(*entry);
+}
+
 /**
  * Add the landscape to the viewport, i.e. all ground tiles and buildings.
  */
@@ -1225,6 +1504,7 @@ static void ViewportAddLandscape()
 	 * Due to integer-division not rounding down for negative numbers, we need another decrement.
 	 */
 	int row = (upper_left.x + upper_left.y) / (int)TILE_SIZE - 2;
+	uint cached_tiles = 0;
 	bool last_row = false;
 	for (; !last_row; row++) {
 		last_row = true;
@@ -1301,7 +1581,12 @@ static void ViewportAddLandscape()
 				_vd.last_foundation_child[0] = NULL;
 				_vd.last_foundation_child[1] = NULL;
 
-				_tile_type_procs[tile_type]->draw_tile_proc(&tile_info);
+				if (cached_tiles < VIEWPORT_TILE_SPRITE_CACHE_DRAW_LIMIT && ViewportIsTileSpriteCacheable(&tile_info, tile_type)) {
+					cached_tiles++;
+					ViewportDrawTileCached(&tile_info, tile_type);
+				} else {
+					_tile_type_procs[tile_type]->draw_tile_proc(&tile_info);
+				}
 				if (tile_info.tile != INVALID_TILE) {
 					DrawTileSelection(&tile_info);
 					DrawTileZoning(&tile_info);
@@ -1561,6 +1846,151 @@ static void ViewportSortParentSprites(ParentSpriteToSortVector *psdv)
 	}
 }
 
+/**
+ * Sort parent sprites pointer array, giving exactly the same order as #ViewportSortParentSprites.
+ *
+ * That sorter takes the first sprite which was not compared yet and moves every later sprite, which has to be
+ * drawn before it, to the front; the last one moved is the next sprite to compare. Only sprites with
+ * xmin + ymin <= xmax + ymax of the compared sprite can have to be drawn before it, so the sprites not compared yet
+ * are kept in a list ordered by xmin + ymin, i.e. by their row on the screen, and only its front is scanned.
+ * The position of each sprite in the sequence of the original sorter is tracked by a label; sprites moved to the
+ * front get decreasing labels, which keeps the relative order of all other sprites intact.
+ * This makes the cost depend on the number of sprites in the same screen rows instead of on all sprites.
+ */
+static void ViewportSortParentSpritesBucketed(ParentSpriteToSortVector *psdv)
+{
+	const uint count = psdv->Length();
+	if (count < 2) return;
+
+	typedef std::pair<int, uint> LabelledSprite; ///< Label and index of a sprite.
+	typedef std::priority_queue<LabelledSprite, std::vector<LabelledSprite>, std::greater<LabelledSprite>> LabelQueue;
+
+	static const uint INVALID_SPRITE = UINT_MAX;
+
+	static std::vector<ParentSpriteToDraw *> sprites;
+	static std::vector<int> label;
+	static std::vector<int> row;
+	static std::vector<uint> row_order;
+	static std::vector<uint> row_prev;
+	static std::vector<uint> row_next;
+	static std::vector<bool> compared_flag;
+	static std::vector<uint> preceding;
+
+	sprites.assign(psdv->Begin(), psdv->End());
+	label.resize(count);
+	row.resize(count);
+	row_order.resize(count);
+	row_prev.resize(count);
+	row_next.resize(count);
+	compared_flag.assign(count, false);
+
+	std::vector<LabelledSprite> initial(count);
+	for (uint i = 0; i < count; i++) {
+		label[i] = i;
+		row[i] = sprites[i]->xmin + sprites[i]->ymin;
+		row_order[i] = i;
+		initial[i] = LabelledSprite(i, i);
+	}
+	std::sort(row_order.begin(), row_order.end(), [](uint a, uint b) { return row[a] < row[b]; });
+
+	uint row_head = row_order[0];
+	for (uint i = 0; i < count; i++) {
+		row_prev[row_order[i]] = i == 0 ? INVALID_SPRITE : row_order[i - 1];
+		row_next[row_order[i]] = i + 1 == count ? INVALID_SPRITE : row_order[i + 1];
+	}
+
+	LabelQueue pending(std::greater<LabelledSprite>(), std::move(initial)); ///< Sprites not compared yet, may contain outdated labels.
+	LabelQueue compared; ///< Sprites already compared but not output yet.
+	int front_label = 0;
+	ParentSpriteToDraw **out = psdv->Begin();
+
+	while (!pending.empty()) {
+		const LabelledSprite current = pending.top();
+		pending.pop();
+		const uint a = current.second;
+		if (compared_flag[a] || label[a] != current.first) continue;
+
+		/* Compared sprites in front of the current one will not move anymore. */
+		while (!compared.empty() && compared.top().first < current.first) {
+			*out++ = sprites[compared.top().second];
+			compared.pop();
+		}
+
+		compared_flag[a] = true;
+		compared.push(current);
+		if (row_prev[a] != INVALID_SPRITE) row_next[row_prev[a]] = row_next[a];
+		if (row_next[a] != INVALID_SPRITE) row_prev[row_next[a]] = row_prev[a];
+		if (row_head == a) row_head = row_next[a];
+
+		const ParentSpriteToDraw *ps = sprites[a];
+		const int max_row = ps->xmax + ps->ymax;
+		preceding.clear();
+		for (uint b = row_head; b != INVALID_SPRITE && row[b] <= max_row; b = row_next[b]) {
+			const ParentSpriteToDraw *ps2 = sprites[b];
+
+			/* Same comparison as in ViewportSortParentSprites. */
+			if (ps->xmax >= ps2->xmin && ps->xmin <= ps2->xmax && // overlap in X?
+					ps->ymax >= ps2->ymin && ps->ymin <= ps2->ymax && // overlap in Y?
+					ps->zmax >= ps2->zmin && ps->zmin <= ps2->zmax) { // overlap in Z?
+				if (ps->xmin + ps->xmax + ps->ymin + ps->ymax + ps->zmin + ps->zmax <=
+						ps2->xmin + ps2->xmax + ps2->ymin + ps2->ymax + ps2->zmin + ps2->zmax) {
+					continue;
+				}
+			} else {
+				if (ps->xmax < ps2->xmin ||
+						ps->ymax < ps2->ymin ||
+						ps->zmax < ps2->zmin) {
+					continue;
+				}
+			}
+
+			preceding.push_back(b);
+		}
+
+		/* The original sorter finds the preceding sprites in sequence order and moves each one to the front. */
+		std::sort(preceding.begin(), preceding.end(), [](uint a, uint b) { return label[a] < label[b]; });
+		for (uint i = 0; i < preceding.size(); i++) {
+			label[preceding[i]] = --front_label;
+			pending.push(LabelledSprite(label[preceding[i]], preceding[i]));
+		}
+	}
+
+	while (!compared.empty()) {
+		*out++ = sprites[compared.top().second];
+		compared.pop();
+	}
+	assert(out == psdv->End());
+}
+
+/**
+ * Sort parent sprites with #ViewportSortParentSpritesBucketed.
+ * With a sprite debug level of at least 5 the result is compared with #ViewportSortParentSprites.
+ */
+static void ViewportSortParentSpritesBucketedChecked(ParentSpriteToSortVector *psdv)
+{
+	if (_debug_sprite_level < 5) {
+		ViewportSortParentSpritesBucketed(psdv);
+		return;
+	}
+
+	ParentSpriteToSortVector reference;
+	for (ParentSpriteToDraw **it = psdv->Begin(); it != psdv->End(); it++) {
+		(*it)->comparison_done = false;
+		*reference.Append() = *it;
+	}
+
+	ViewportSortParentSpritesBucketed(psdv);
+	ViewportSortParentSprites(&reference);
+
+	for (uint i = 0; i < psdv->Length(); i++) {
+		if (*psdv->Get(i) != *reference.Get(i)) {
+			DEBUG(sprite, 0, "Bucketed parent sprite sorter differs from the reference at position %u of %u", i, psdv->Length());
+			return;
+		}
+	}
+	DEBUG(sprite, 9, "Bucketed parent sprite sorter matches the reference for %u sprites", psdv->Length());
+}
+
 static void ViewportDrawParentSprites(const ParentSpriteToSortVector *psd, const ChildScreenSpriteToDrawVector *csstdv)
 {
 	const ParentSpriteToDraw * const *psd_end = psd->End();
@@ -1577,6 +2007,89 @@ static void ViewportDrawParentSprites(const ParentSpriteToSortVector *psd, const
 	}
 }
 
+/** Minimum height of the bands of the viewport which are drawn in parallel, in screen pixels. */
+static const int VIEWPORT_DRAW_MIN_BAND_HEIGHT = 64;
+
+/**
+ * Load a sprite and its recolour sprite as used by #DrawSpriteViewportToArea into the sprite cache.
+ * @param image Image number of the sprite.
+ * @param pal Palette of the sprite.
+ */
+static void ViewportPrefetchSprite(SpriteID image, PaletteID pal)
+{
+	if (HasBit(image, PALETTE_MODIFIER_TRANSPARENT) || (pal != PAL_NONE && !HasBit(pal, PALETTE_TEXT_RECOLOUR))) {
+		GetNonSprite(GB(pal, 0, PALETTE_WIDTH), ST_RECOLOUR);
+	}
+	GetSprite(GB(image, 0, SPRITE_WIDTH), ST_NORMAL);
+}
+
+/**
+ * Draw the tile sprites and the sorted parent sprites, split over horizontal bands which are drawn by the worker threads.
+ * The sprites are loaded into the sprite cache first, which is then read-only while the bands are drawn.
+ * @param tstdv Tile sprites to draw.
+ * @param psd Sorted parent sprites to draw.
+ * @param csstdv Child sprites of the parent sprites.
+ * @return false if the sprites can not be drawn in parallel, and have to be drawn by the caller.
+ */
+static bool ViewportDrawSpritesParallel(const TileSpriteToDrawVector *tstdv, const ParentSpriteToSortVector *psd, const ChildScreenSpriteToDrawVector *csstdv)
+{
+	/* The sprite picker collects the drawn sprites into a shared list. */
+	if (_newgrf_debug_sprite_picker.mode == SPM_REDRAW) return false;
+
+	const DrawPixelInfo &area = _vd.dpi;
+	int height = UnScaleByZoom(area.height, area.zoom);
+	uint bands = min<uint>(ThreadPool::GetWorkerCount() + 1, height / VIEWPORT_DRAW_MIN_BAND_HEIGHT);
+	if (bands < 2) return false;
+
+	/* When sprites were evicted or moved while loading, some of them may not be in the cache anymore. */
+	uint32 generation = GetSpriteCacheGeneration();
+	const TileSpriteToDraw *tsend = tstdv->End();
+	for (const TileSpriteToDraw *ts = tstdv->Begin(); ts != tsend; ++ts) {
+		ViewportPrefetchSprite(ts->image, ts->pal);
+	}
+	const ParentSpriteToDraw * const *psd_end = psd->End();
+	for (const ParentSpriteToDraw * const *it = psd->Begin(); it != psd_end; it++) {
+		const ParentSpriteToDraw *ps = *it;
+		if (ps->image != SPR_EMPTY_BOUNDING_BOX) ViewportPrefetchSprite(ps->image, ps->pal);
+		for (int child_idx = ps->first_child; child_idx >= 0; child_idx = csstdv->Get(child_idx)->next) {
+			const ChildScreenSpriteToDraw *cs = csstdv->Get(child_idx);
+			ViewportPrefetchSprite(cs->image, cs->pal);
+		}
+	}
+	if (GetSpriteCacheGeneration() != generation) return false;
+
+	Blitter *blitter = BlitterFactory::GetCurrentBlitter();
+	SetSpriteCacheReadOnly(true);
+	ThreadPool::ParallelFor(bands, 1, [&](size_t begin, size_t end) {
+		for (size_t band = begin; band < end; band++) {
+			int band_top = height * (int)band / (int)bands;
+			int band_bottom = height * (int)(band + 1) / (int)bands;
+
+			DrawPixelInfo dpi = area;
+			dpi.top = area.top + ScaleByZoom(band_top, area.zoom);
+			dpi.height = ScaleByZoom(band_bottom - band_top, area.zoom);
+			dpi.dst_ptr = blitter->MoveTo(area.dst_ptr, 0, band_top);
+
+			for (const TileSpriteToDraw *ts = tstdv->Begin(); ts != tsend; ++ts) {
+				DrawSpriteViewportToArea(&dpi, ts->image, ts->pal, ts->x, ts->y, ts->sub);
+			}
+			for (const ParentSpriteToDraw * const *it = psd->Begin(); it != psd_end; it++) {
+				const ParentSpriteToDraw *ps = *it;
+				if (ps->image != SPR_EMPTY_BOUNDING_BOX) DrawSpriteViewportToArea(&dpi, ps->image, ps->pal, ps->x, ps->y, ps->sub);
+
+				for (int child_idx = ps->first_child; child_idx >= 0;) {
+					const ChildScreenSpriteToDraw *cs = csstdv->Get(child_idx);
+					child_idx = cs->next;
+					DrawSpriteViewportToArea(&dpi, cs->image, cs->pal, ps->left + cs->x, ps->top + cs->y, cs->sub);
+				}
+			}
+		}
+	});
+	SetSpriteCacheReadOnly(false);
+
+	return true;
+}
+
 /**
  * Draws the bounding boxes of all ParentSprites
  * @param psd Array of ParentSprites
@@ -2290,9 +2803,95 @@ static inline TileIndex ViewportMapGetMostSignificantTileType(const ViewPort * c
 	return result;
 }
 
+/** State of a tile in a #ViewportMapTileColourCache. */
+enum ViewportMapTileColourState {
+	VMTCS_STALE,  ///< The colour of the tile has to be computed again.
+	VMTCS_CACHED, ///< The colour of the tile is cached.
+	VMTCS_VARIES, ///< The colour of the tile depends on the pixel position, it is never cached.
+};
+
+/**
+ * Map sized raster of the colours of the tiles in one viewport map mode.
+ * It is filled lazily while drawing and updated per tile by #MarkTileDirtyByTile.
+ */
+struct ViewportMapTileColourCache {
+	uint32 key;                  ///< Drawing configuration the cached colours belong to.
+	uint32 generation;           ///< Value of #_vp_map_tile_colour_generation when the cache was last reset.
+	std::vector<uint32> colours; ///< Cached colour of each tile.
+	std::vector<byte> state;     ///< #ViewportMapTileColourState of each tile.
+};
+
+static ViewportMapTileColourCache _vp_map_tile_colour_cache[VPMT_END]; ///< Tile colour rasters, one per map mode.
+static uint32 _vp_map_tile_colour_generation = 0;                      ///< Incremented whenever all cached tile colours become invalid.
+
+/** Free the tile colour rasters of all map modes, for example when a new map is allocated. */
+void AllocateViewportMapTileColourCache()
+{
+	for (uint i = 0; i < lengthof(_vp_map_tile_colour_cache); i++) {
+		std::vector<uint32>().swap(_vp_map_tile_colour_cache[i].colours);
+		std::vector<byte>().swap(_vp_map_tile_colour_cache[i].state);
+	}
+}
+
+/** Mark the cached colours of all tiles as stale, for example because a legend or company colour changed. */
+void InvalidateViewportMapTileColourCache()
+{
+	_vp_map_tile_colour_generation++;
+}
+
+/**
+ * Mark the cached colour of a tile as stale.
+ * @param tile The tile which changed.
+ */
+static void InvalidateViewportMapTileColour(TileIndex tile)
+{
+	for (uint i = 0; i < lengthof(_vp_map_tile_colour_cache); i++) {
+		ViewportMapTileColourCache &cache = _vp_map_tile_colour_cache[i];
+		if (tile < cache.state.size()) cache.state[tile] = VMTCS_STALE;
+	}
+}
+
+/**
+ * Get the tile colour raster of a map mode, ready for drawing with the current settings.
+ * @param map_type The map mode to draw.
+ * @return The raster.
+ */
+template <bool is_32bpp, bool show_slope>
+static ViewportMapTileColourCache *ViewportMapPrepareTileColourCache(ViewportMapType map_type)
+{
+	extern bool _smallmap_show_heightmap;
+
+	const uint32 key = (is_32bpp ? 1 : 0) | (show_slope ? 2 : 0) |
+			(IsTransparencySet(TO_TREES) ? 4 : 0) | (IsInvisibilitySet(TO_TREES) ? 8 : 0) |
+			(_smallmap_show_heightmap ? 16 : 0) | (_settings_client.gui.smallmap_land_colour << 5) |
+			(_settings_game.construction.max_heightlevel << 8);
+
+	ViewportMapTileColourCache &cache = _vp_map_tile_colour_cache[map_type];
+	if (cache.state.size() != MapSize()) {
+		cache.colours.assign(MapSize(), 0);
+		cache.state.assign(MapSize(), VMTCS_STALE);
+	} else if (cache.key != key || cache.generation != _vp_map_tile_colour_generation) {
+		std::fill(cache.state.begin(), cache.state.end(), VMTCS_STALE);
+	}
+	cache.key = key;
+	cache.generation = _vp_map_tile_colour_generation;
+	return &cache;
+}
+
+/** Get the colour of a tile in the map mode of a viewport, without looking at the tile colour raster. */
+template <bool is_32bpp, bool show_slope>
+static inline uint32 ViewportMapGetTileColour(const ViewPort * const vp, const TileIndex tile, const TileType tile_type, const uint colour_index)
+{
+	switch (vp->map_type) {
+		default:              return ViewportMapGetColourOwner<is_32bpp, show_slope>(tile, tile_type, colour_index);
+		case VPMT_INDUSTRY:   return ViewportMapGetColourIndustries<is_32bpp, show_slope>(tile, tile_type, colour_index);
+		case VPMT_VEGETATION: return ViewportMapGetColourVegetation<is_32bpp, show_slope>(tile, tile_type, colour_index);
+	}
+}
+
 /** Get the colour of a tile, can be 32bpp RGB or 8bpp palette index. */
 template <bool is_32bpp, bool show_slope>
-uint32 ViewportMapGetColour(const ViewPort * const vp, uint x, uint y, const uint colour_index)
+uint32 ViewportMapGetColour(const ViewPort * const vp, ViewportMapTileColourCache * const cache, uint x, uint y, const uint colour_index)
 {
 	if (!(IsInsideMM(x, TILE_SIZE, MapMaxX() * TILE_SIZE - 1) &&
 		  IsInsideMM(y, TILE_SIZE, MapMaxY() * TILE_SIZE - 1)))
@@ -2317,11 +2916,23 @@ uint32 ViewportMapGetColour(const ViewPort * const vp, uint x, uint y, const uin
 	if (tile_type == MP_VOID) return 0;
 
 	/* Return the colours. */
-	switch (vp->map_type) {
-		default:              return ViewportMapGetColourOwner<is_32bpp, show_slope>(tile, tile_type, colour_index);
-		case VPMT_INDUSTRY:   return ViewportMapGetColourIndustries<is_32bpp, show_slope>(tile, tile_type, colour_index);
-		case VPMT_VEGETATION: return ViewportMapGetColourVegetation<is_32bpp, show_slope>(tile, tile_type, colour_index);
+	switch (cache->state[tile]) {
+		case VMTCS_CACHED: return cache->colours[tile];
+		case VMTCS_VARIES: return ViewportMapGetTileColour<is_32bpp, show_slope>(vp, tile, tile_type, colour_index);
+		default: break;
+	}
+
+	/* Houses, town roads, fields and the like are dithered; only cache tiles which look the same for each colour index. */
+	const uint32 colour = ViewportMapGetTileColour<is_32bpp, show_slope>(vp, tile, tile_type, colour_index);
+	cache->state[tile] = VMTCS_CACHED;
+	for (uint i = 1; i < 4; i++) {
+		if (ViewportMapGetTileColour<is_32bpp, show_slope>(vp, tile, tile_type, (colour_index + i) & 3) != colour) {
+			cache->state[tile] = VMTCS_VARIES;
+			break;
+		}
 	}
+	cache->colours[tile] = colour;
+	return colour;
 }
 
 /* Taken from http://stereopsis.com/doubleblend.html, PixelBlend() is faster than ComposeColourRGBANoCheck() */
@@ -2434,6 +3045,7 @@ void ViewportMapDraw(const ViewPort * const vp)
 	Blitter * const blitter = BlitterFactory::GetCurrentBlitter();
 
 	SmallMapWindow::RebuildColourIndexIfNecessary();
+	ViewportMapTileColourCache * const cache = ViewportMapPrepareTileColourCache<is_32bpp, show_slope>(vp->map_type);
 
 	/* Index of colour: _green_map_heights[] contains blocks of 4 colours, say ABCD
 	 * For a XXXY colour block to render nicely, follow the model:
@@ -2466,10 +3078,10 @@ void ViewportMapDraw(const ViewPort * const vp)
 		int d = b + a;
 		do { // For each pixel of a line
 			if (is_32bpp) {
-				*vp_map_line_ptr32 = ViewportMapGetColour<is_32bpp, show_slope>(vp, c, d, colour_index);
+				*vp_map_line_ptr32 = ViewportMapGetColour<is_32bpp, show_slope>(vp, cache, c, d, colour_index);
 				vp_map_line_ptr32++;
 			} else {
-				*vp_map_line_ptr8 = (uint8) ViewportMapGetColour<is_32bpp, show_slope>(vp, c, d, colour_index);
+				*vp_map_line_ptr8 = (uint8) ViewportMapGetColour<is_32bpp, show_slope>(vp, cache, c, d, colour_index);
 				vp_map_line_ptr8++;
 			}
 			colour_index = (colour_index + 1) & 3;
@@ -2566,15 +3178,17 @@ void ViewportDoDraw(const ViewPort *vp, int left, int top, int right, int bottom
 
 		DrawTextEffects(&_vd.dpi);
 
-		if (_vd.tile_sprites_to_draw.Length() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
-
 		ParentSpriteToDraw *psd_end = _vd.parent_sprites_to_draw.End();
 		for (ParentSpriteToDraw *it = _vd.parent_sprites_to_draw.Begin(); it != psd_end; it++) {
 			*_vd.parent_sprites_to_sort.Append() = it;
 		}
 
 		_vp_sprite_sorter(&_vd.parent_sprites_to_sort);
-		ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
+
+		if (!ViewportDrawSpritesParallel(&_vd.tile_sprites_to_draw, &_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw)) {
+			if (_vd.tile_sprites_to_draw.Length() != 0) ViewportDrawTileSprites(&_vd.tile_sprites_to_draw);
+			ViewportDrawParentSprites(&_vd.parent_sprites_to_sort, &_vd.child_screen_sprites_to_draw);
+		}
 
 		if (_draw_bounding_boxes) ViewportDrawBoundingBoxes(&_vd.parent_sprites_to_sort);
 	}
@@ -2976,6 +3590,10 @@ void ConstrainAllViewportsZoom()
  */
 void MarkTileDirtyByTile(TileIndex tile, const ZoomLevel mark_dirty_if_zoomlevel_is_below, int bridge_level_offset)
 {
+	InvalidateViewportTileSprites(tile);
+	/* Changes which are not visible in map mode do not affect the tile colour raster. */
+	if (mark_dirty_if_zoomlevel_is_below > ZOOM_LVL_DRAW_MAP) InvalidateViewportMapTileColour(tile);
+
 	Point pt = RemapCoords(TileX(tile) * TILE_SIZE, TileY(tile) * TILE_SIZE, TilePixelHeight(tile));
 	MarkAllViewportsDirty(
 			pt.x - 31  * ZOOM_LVL_BASE,
@@ -4780,6 +5398,7 @@ struct ViewportSSCSS {
 
 /** List of sorters ordered from best to worst. */
 static ViewportSSCSS _vp_sprite_sorters[] = {
+	{ &ViewportSortParentSpritesChecker, &ViewportSortParentSpritesBucketedChecked },
 #ifdef WITH_SSE
 	{ &ViewportSortParentSpritesSSE41Checker, &ViewportSortParentSpritesSSE41 },
 #endif
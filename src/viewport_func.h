@@ -89,6 +89,11 @@ void MarkTileDirtyByTile(const TileIndex tile, const ZoomLevel mark_dirty_if_zoo
 
 void MarkTileDirtyByTileOutsideMap(int x, int y);
 
+void AllocateViewportMapTileColourCache();
+void InvalidateViewportMapTileColourCache();
+void ClearViewportTileSpriteCache();
+void InvalidateViewportTileSpriteCache();
+
 ViewportMapType ChangeRenderMode(const ViewPort *vp, bool down);
 
 Point GetViewportStationMiddle(const ViewPort *vp, const Station *st);
@@ -29,6 +29,7 @@
 #include "company_base.h"
 #include "water.h"
 #include "company_gui.h"
+#include "pathfinder/water_regions.h"
 
 #include "table/strings.h"
 
@@ -324,6 +325,7 @@ CommandCost CmdBuildBuoy(TileIndex tile, DoCommandFlag flags, uint32 p1, uint32
 		if (wp->town == NULL) MakeDefaultName(wp);
 
 		MakeBuoy(tile, wp->index, GetWaterClass(tile));
+		InvalidateWaterRegion(tile);
 		MarkTileDirtyByTile(tile);
 
 		wp->UpdateVirtCoord();
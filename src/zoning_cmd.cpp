@@ -60,16 +60,14 @@ void DrawZoningSprites(SpriteID image, SpriteID colour, const TileInfo *ti)
  */
 bool IsAreaWithinAcceptanceZoneOfStation(TileArea area, Owner owner, StationFacility facility_mask)
 {
-	int catchment = _settings_game.station.station_spread + (_settings_game.station.modified_catchment ? MAX_CATCHMENT : CA_UNMODIFIED) + _settings_game.station.catchment_increase;
+	StationList stations;
+	GetStationCatchmentIndexCandidates(area, &stations);
 
-	StationFinder morestations(TileArea(TileXY(TileX(area.tile) - (catchment / 2), TileY(area.tile) - (catchment / 2)),
-			TileX(area.tile) + area.w + catchment, TileY(area.tile) + area.h + catchment));
-
-	for (Station * const *st_iter = morestations.GetStations()->Begin(); st_iter != morestations.GetStations()->End(); ++st_iter) {
+	for (Station * const *st_iter = stations.Begin(); st_iter != stations.End(); ++st_iter) {
 		const Station *st = *st_iter;
-		if (st->owner != owner || !(st->facilities & facility_mask)) continue;
+		if (st->owner != owner || !(st->facilities & facility_mask) || st->rect.IsEmpty()) continue;
 		Rect rect = st->GetCatchmentRect();
-		return TileArea(TileXY(rect.left, rect.top), TileXY(rect.right, rect.bottom)).Intersects(area);
+		if (TileArea(TileXY(rect.left, rect.top), TileXY(rect.right, rect.bottom)).Intersects(area)) return true;
 	}
 
 	return false;
@@ -90,14 +88,12 @@ bool IsAreaWithinAcceptanceZoneOfStation(TileArea area, Owner owner, StationFaci
  */
 bool IsTileWithinAcceptanceZoneOfStation(TileIndex tile, Owner owner, StationFacility facility_mask, bool open_window_only)
 {
-	int catchment = _settings_game.station.station_spread + (_settings_game.station.modified_catchment ? MAX_CATCHMENT : CA_UNMODIFIED) + _settings_game.station.catchment_increase;
-
-	StationFinder morestations(TileArea(TileXY(TileX(tile) - (catchment / 2), TileY(tile) - (catchment / 2)),
-			catchment, catchment));
+	StationList stations;
+	GetStationCatchmentIndexCandidates(TileArea(tile, 1, 1), &stations);
 
-	for (Station * const *st_iter = morestations.GetStations()->Begin(); st_iter != morestations.GetStations()->End(); ++st_iter) {
+	for (Station * const *st_iter = stations.Begin(); st_iter != stations.End(); ++st_iter) {
 		const Station *st = *st_iter;
-		if (st->owner != owner || !(st->facilities & facility_mask)) continue;
+		if (st->owner != owner || !(st->facilities & facility_mask) || st->rect.IsEmpty()) continue;
 		Rect rect = st->GetCatchmentRect();
 		if ((uint)rect.left <= TileX(tile) && TileX(tile) <= (uint)rect.right
 				&& (uint)rect.top <= TileY(tile) && TileY(tile) <= (uint)rect.bottom) {